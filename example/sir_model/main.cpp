@@ -1,7 +1,11 @@
 #include <abmoid/agent.hpp>
 #include <abmoid/agent_component.hpp>
+#include <abmoid/dopri5.hpp>
+#include <abmoid/dual.hpp>
 #include <abmoid/rk4.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <random>
 #include <ranges>
@@ -147,11 +151,14 @@ public:
   }
 };
 
+// Scalar is double or a number type such as abmoid::dual to also
+// find derivatives with respect to the parameters.
+template <typename Scalar = double>
 struct ode_sir_model {
   struct state {
-    double S;
-    double I;
-    double R;
+    Scalar S;
+    Scalar I;
+    Scalar R;
 
     state operator+(state const& other) const {
       return state{.S = S + other.S,
@@ -159,11 +166,34 @@ struct ode_sir_model {
                    .R = R + other.R};
     }
 
+    friend state operator*(double k, state const& self) {
+      return {.S = k * self.S,
+              .I = k * self.I,
+              .R = k * self.R};
+    }
+
+    friend state operator*(state const& self, double k) {
+      return k * self;
+    }
+
+    // Steps are chosen by the error in the values only.
+    friend double error_norm(state const& err, state const& x,
+                             state const& x_new, abmoid::tolerance tol) {
+      using abmoid::value_of;
+      auto scaled = [&](Scalar const& e, Scalar const& a, Scalar const& b) {
+        double scale = tol.abs + tol.rel * std::max(std::abs(value_of(a)),
+                                                    std::abs(value_of(b)));
+        return (value_of(e) / scale) * (value_of(e) / scale);
+      };
+      return std::sqrt((scaled(err.S, x.S, x_new.S) +
+                        scaled(err.I, x.I, x_new.I) +
+                        scaled(err.R, x.R, x_new.R)) / 3.0);
+    }
   };
 
-  double N;     // Total population
-  double beta;  // Transmission rate (per day)
-  double gamma; // Recovery rate (per 1/day)
+  Scalar N;     // Total population
+  Scalar beta;  // Transmission rate (per day)
+  Scalar gamma; // Recovery rate (per 1/day)
 
   state operator()(double t, state vec) const {
     auto [S, I, R] = vec;
@@ -175,16 +205,6 @@ struct ode_sir_model {
   }
 };
 
-ode_sir_model::state operator*(double k, ode_sir_model::state const& self) {
-  return {.S = k * self.S,
-          .I = k * self.I,
-          .R = k * self.R};
-}
-
-ode_sir_model::state operator*(ode_sir_model::state const& self, double k) {
-  return k * self;
-}
-
 template <typename HandleFn>
 void run_sir_agent(unsigned seed, parameters params, unsigned total_frames,
                    HandleFn handle) {
@@ -203,22 +223,61 @@ void run_sir_ode(parameters params, unsigned total_frames, HandleFn handle) {
   double N    = static_cast<double>(params.N);
   double I_0  = static_cast<double>(params.I_0);
 
-  ode_sir_model sir{.N      = static_cast<double>(N),
-                    .beta   = params.beta,
-                    .gamma  = params.gamma};
-  ode_sir_model::state init_state{
+  ode_sir_model<> sir{.N      = static_cast<double>(N),
+                      .beta   = params.beta,
+                      .gamma  = params.gamma};
+  ode_sir_model<>::state init_state{
     .S = N - I_0,
     .I = I_0,
     .R = 0.0};
 
-  auto step_result = [&](ode_sir_model::state state, abmoid::time_t t) {
+  auto step_result = [&](ode_sir_model<>::state state, abmoid::time_t t) {
     auto [S, I, R] = state;
     handle(S, I, R, t);
   };
 
-  // Calculate stuff.
-  abmoid::rk4(sir, step_result, init_state,
-              abmoid::time_step{0.01}, total_frames * 100);
+  // Calculate stuff at each frame.
+  abmoid::step_stats stats = abmoid::dopri5(
+    sir, step_result, init_state,
+    std::views::iota(0u, total_frames) | std::views::transform(
+      [](unsigned frame) { return static_cast<abmoid::time_t>(frame); }),
+    abmoid::tolerance{.abs = 1e-6, .rel = 1e-6});
+  std::cerr << "ODE: " << stats.accepted << " steps, " <<
+               stats.rejected << " rejected, " <<
+               stats.evaluations << " evaluations\n";
+}
+
+// Report the derivatives of the final infected and recovered counts
+// with respect to beta and gamma found in a single pass with dual
+// numbers.
+void report_sir_ode_sensitivity(parameters params, unsigned total_frames) {
+  using number = abmoid::dual<2>;
+  double N    = static_cast<double>(params.N);
+  double I_0  = static_cast<double>(params.I_0);
+
+  ode_sir_model<number> sir{.N      = N,
+                            .beta   = number::variable(params.beta, 0),
+                            .gamma  = number::variable(params.gamma, 1)};
+  ode_sir_model<number>::state init_state{
+    .S = N - I_0,
+    .I = I_0,
+    .R = 0.0};
+
+  ode_sir_model<number>::state final_state = init_state;
+  abmoid::time_t final_time = total_frames - 1;
+  abmoid::dopri5(
+    sir, [&](ode_sir_model<number>::state state, abmoid::time_t) {
+      final_state = state;
+    },
+    init_state, std::views::single(final_time),
+    abmoid::tolerance{.abs = 1e-6, .rel = 1e-6});
+
+  auto [dI_dbeta, dI_dgamma] = final_state.I.derivatives;
+  auto [dR_dbeta, dR_dgamma] = final_state.R.derivatives;
+  std::cerr << "ODE sensitivity at t = " << final_time << ": " <<
+               "dI/dbeta = " << dI_dbeta << ", dI/dgamma = " << dI_dgamma <<
+               ", dR/dbeta = " << dR_dbeta << ", dR/dgamma = " << dR_dgamma <<
+               '\n';
 }
 
 int main() {
@@ -236,6 +295,7 @@ int main() {
   auto begin_new_dataset = [] { std::cout << "\n\n"; };
 
   run_sir_ode(params, total_frames, print_csv_row);
+  report_sir_ode_sensitivity(params, total_frames);
 
   for (int i = 0; i < 100; i++) {
     begin_new_dataset();
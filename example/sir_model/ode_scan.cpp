@@ -0,0 +1,75 @@
+#include <abmoid/ensemble.hpp>
+#include <abmoid/rk4.hpp>
+#include <abmoid/thread_pool.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Scan the SIR ODE over a grid of (beta, gamma) and print the peak
+// infected count, sampled once per frame, and the final recovered
+// count of each scenario.
+int main() {
+  constexpr unsigned total_frames = 364;
+  constexpr unsigned steps_per_frame = 100;
+  constexpr std::size_t num_beta = 64;
+  constexpr std::size_t num_gamma = 64;
+  constexpr std::size_t scenarios = num_beta * num_gamma;
+  constexpr double N = 10'000;
+  constexpr double I_0 = 10;
+
+  std::vector<double> beta(scenarios);
+  std::vector<double> gamma(scenarios);
+  for (std::size_t i = 0; i < num_beta; ++i) {
+    for (std::size_t j = 0; j < num_gamma; ++j) {
+      beta[i * num_gamma + j] = 0.10 + 0.40 * i / (num_beta - 1);
+      gamma[i * num_gamma + j] = 0.05 + 0.15 * j / (num_gamma - 1);
+    }
+  }
+
+  // S, I and R rows with one lane per scenario.
+  std::vector<double> x(3 * scenarios);
+  std::ranges::fill(std::span(x).subspan(0, scenarios), N - I_0);
+  std::ranges::fill(std::span(x).subspan(scenarios, scenarios), I_0);
+  std::vector<double> I_max(scenarios, I_0);
+
+  auto sir = [&](abmoid::time_t, std::size_t first,
+                 abmoid::lanes_view<double const> x,
+                 abmoid::lanes_view<double> dxdt) {
+    auto S = x[0];
+    auto I = x[1];
+    for (std::size_t i = 0; i < x.size(); ++i) {
+      double infections = beta[first + i] * I[i] * S[i] / N;
+      double recoveries = gamma[first + i] * I[i];
+      dxdt[0][i] = -infections;
+      dxdt[1][i] = infections - recoveries;
+      dxdt[2][i] = recoveries;
+    }
+  };
+
+  auto track_peak = [&](std::size_t first,
+                        abmoid::lanes_view<double const> x,
+                        abmoid::time_t) {
+    auto I = x[1];
+    for (std::size_t i = 0; i < x.size(); ++i)
+      I_max[first + i] = std::max(I_max[first + i], I[i]);
+  };
+
+  abmoid::thread_pool pool(std::thread::hardware_concurrency());
+  abmoid::ensemble_rk4(pool, sir, track_peak, x, 3,
+                       abmoid::time_step{1.0 / steps_per_frame},
+                       total_frames * steps_per_frame,
+                       abmoid::every_k_steps{steps_per_frame});
+
+  std::cout << "# beta, gamma, I_max, R\n";
+  for (std::size_t i = 0; i < num_beta; ++i) {
+    for (std::size_t j = 0; j < num_gamma; ++j) {
+      std::size_t s = i * num_gamma + j;
+      std::cout << beta[s] << ',' << gamma[s] << ',' <<
+                   I_max[s] << ',' << x[2 * scenarios + s] << '\n';
+    }
+    std::cout << '\n';
+  }
+}
@@ -0,0 +1,53 @@
+#include <iostream>
+
+#include "abc_calibration.hpp"
+#include "sir_social.hpp"
+
+// Two groups with some people in both where the infection starts
+// in A.
+sir_social::parameters make_params(abc::point<2> const& beta) {
+  using sir_social::connection_spec;
+  using sir_social::group_params;
+
+  return sir_social::parameters{
+    .gamma  = 0.10,
+    .groups{
+      group_params{.name = "A", .beta = beta[0], .contact_factor = 2},
+      group_params{.name = "B", .beta = beta[1], .contact_factor = 2}
+    },
+    .connections{
+      connection_spec{.groups = {"A"}, .N = 5'000, .I_0 = 20},
+      connection_spec{.groups = {"B"}, .N = 5'000, .I_0 = 0},
+      connection_spec{.groups = {"A", "B"}, .N = 100, .I_0 = 0}
+    }
+  };
+}
+
+// Recover the beta of each group from a run with known values.
+int main() {
+  constexpr unsigned total_frames = 364;
+  constexpr abc::point<2> true_beta{0.24, 0.32};
+
+  sir_social::agent_model observed(make_params(true_beta), 12345);
+  abc::trajectory target = abc::record(observed, total_frames);
+
+  abc::uniform_prior<2> prior{.lower = {0.1, 0.1}, .upper = {0.5, 0.5}};
+  abc::result<2> result = abc::calibrate(make_params, prior, target,
+                                         abc::options{.particles = 100,
+                                                      .rounds = 5});
+
+  for (abc::round_stats const& round : result.rounds) {
+    std::cerr << "threshold " << round.threshold << ": " <<
+                 round.accepted << " accepted of " << round.runs <<
+                 " runs, " << round.rejected_early <<
+                 " rejected early, " <<
+                 100.0 * round.frames / round.full_frames <<
+                 "% of frames simulated\n";
+  }
+
+  std::cout << "# beta_A, beta_B, distance, weight\n";
+  for (abc::particle<2> const& p : result.particles) {
+    std::cout << p.theta[0] << ',' << p.theta[1] << ',' <<
+                 p.distance << ',' << p.weight << '\n';
+  }
+}
@@ -0,0 +1,275 @@
+#ifndef SIR_SOCIAL_ABC_CALIBRATION_HPP
+#define SIR_SOCIAL_ABC_CALIBRATION_HPP
+
+#include <abmoid/work_stealing_pool.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <random>
+#include <ranges>
+#include <thread>
+#include <vector>
+
+#include "peak_times.hpp"
+#include "sir_social.hpp"
+
+// Approximate Bayesian computation for the parameters of an
+// agent_model with runs rejected as soon as they stray too far
+// from the target.
+namespace abc {
+
+template <std::size_t D>
+using point = std::array<double, D>;
+
+// A box of parameter values with a uniform prior over it.
+template <std::size_t D>
+struct uniform_prior {
+  point<D> lower;
+  point<D> upper;
+
+  bool contains(point<D> const& theta) const {
+    for (std::size_t d = 0; d < D; ++d)
+      if (theta[d] < lower[d] || theta[d] > upper[d])
+        return false;
+    return true;
+  }
+};
+
+// Infected in each group after each frame stored frame-major.
+struct trajectory {
+  std::size_t groups = 0;
+  std::vector<unsigned> I;
+
+  std::size_t frames() const {
+    return groups == 0 ? 0 : I.size() / groups;
+  }
+};
+
+template <typename Model>
+trajectory record(Model& model, std::size_t total_frames) {
+  trajectory result{.groups = model.get_group_states().size(), .I = {}};
+  for (std::size_t t = 0; t < total_frames; ++t) {
+    model.update();
+    for (sir_social::group_state const& state : model.get_group_states())
+      result.I.push_back(state.I_count);
+  }
+  return result;
+}
+
+struct run_result {
+  // Root mean square difference from the target over every frame
+  // and group, or over those simulated if rejected early.
+  double distance;
+  std::size_t frames;
+  bool is_accepted;
+};
+
+// Run a model against the target rejecting it as soon as the sum of
+// squared differences so far exceeds the most a run within the
+// threshold could have. The sum only grows so a run rejected early
+// would also have been rejected had it run to the end.
+inline run_result simulate(sir_social::parameters const& params,
+                           sir_social::agent_model::seed_type seed,
+                           trajectory const& target, double threshold) {
+  sir_social::agent_model model(params, seed);
+  std::size_t count = target.I.size();
+  double max_sum = threshold * threshold * count;
+  double sum = 0.0;
+  std::size_t i = 0;
+  for (std::size_t t = 0; t < target.frames(); ++t) {
+    model.update();
+    for (sir_social::group_state const& state : model.get_group_states()) {
+      double diff = static_cast<double>(state.I_count) - target.I[i++];
+      sum += diff * diff;
+    }
+    if (sum > max_sum)
+      return {std::sqrt(sum / i), t + 1, false};
+  }
+  return {std::sqrt(sum / count), target.frames(), true};
+}
+
+struct options {
+  unsigned particles = 100;
+  unsigned rounds = 4;
+  // The threshold of each round after the first is this quantile of
+  // the distances accepted in the round before.
+  double quantile = 0.5;
+  // The threshold of the first round.
+  double initial_threshold = std::numeric_limits<double>::infinity();
+  // Stop a round that has not accepted every particle after this
+  // many runs.
+  std::size_t max_runs_per_round = 100'000;
+  unsigned max_threads = std::thread::hardware_concurrency();
+  std::uint64_t seed = 0;
+};
+
+template <std::size_t D>
+struct particle {
+  point<D> theta;
+  double distance;
+  double weight;
+};
+
+struct round_stats {
+  double threshold;
+  std::size_t runs;
+  std::size_t accepted;
+  std::size_t rejected_early;
+  // Frames simulated and the frames every run would have taken
+  // without early rejection.
+  std::size_t frames;
+  std::size_t full_frames;
+};
+
+template <std::size_t D>
+struct result {
+  std::vector<particle<D>> particles;
+  std::vector<round_stats> rounds;
+};
+
+// Sequential Monte Carlo ABC after Beaumont et al.
+//
+// The first round samples the prior. Each later round lowers the
+// threshold and samples by perturbing particles of the round before
+// with a Gaussian kernel of twice their weighted variance, then
+// weights the accepted particles by the prior over the kernel
+// density. Runs of each round are spread over a pool in waves the
+// size of the population and every run has its own seed, so results
+// do not depend on the number of threads.
+//
+// MakeParamsFn
+//  - sir_social::parameters make_params(point<D> const& theta);
+//  - Runs in the calling thread.
+template <std::size_t D, typename MakeParamsFn>
+result<D> calibrate(MakeParamsFn&& make_params,
+                    uniform_prior<D> const& prior,
+                    trajectory const& target, options opts = {}) {
+  abmoid::work_stealing_pool pool(std::max(opts.max_threads, 1u));
+  std::mt19937_64 gen(opts.seed);
+  sir_social::agent_model::seed_type next_seed = 0;
+
+  result<D> calibration;
+  std::vector<particle<D>> previous;
+  double threshold = opts.initial_threshold;
+  point<D> sigma{};
+
+  auto kernel_density = [&](point<D> const& theta) {
+    double density = 0.0;
+    for (particle<D> const& p : previous) {
+      double exponent = 0.0;
+      for (std::size_t d = 0; d < D; ++d) {
+        double z = (theta[d] - p.theta[d]) / sigma[d];
+        exponent += z * z;
+      }
+      density += p.weight * std::exp(-0.5 * exponent);
+    }
+    return density;
+  };
+
+  auto sample = [&]() {
+    point<D> theta;
+    if (previous.empty()) {
+      for (std::size_t d = 0; d < D; ++d)
+        theta[d] = std::uniform_real_distribution<double>(
+          prior.lower[d], prior.upper[d])(gen);
+      return theta;
+    }
+
+    std::discrete_distribution<std::size_t> pick(
+      previous.size(), 0.0, 1.0,
+      [&, i = std::size_t(0)](double) mutable {
+        return previous[i++].weight;
+      });
+    do {
+      point<D> const& origin = previous[pick(gen)].theta;
+      for (std::size_t d = 0; d < D; ++d)
+        theta[d] = std::normal_distribution<double>(origin[d],
+                                                    sigma[d])(gen);
+    } while (!prior.contains(theta));
+    return theta;
+  };
+
+  for (unsigned round = 0; round < opts.rounds; ++round) {
+    round_stats stats{.threshold = threshold, .runs = 0, .accepted = 0,
+                      .rejected_early = 0, .frames = 0, .full_frames = 0};
+    std::vector<particle<D>> current;
+
+    while (current.size() < opts.particles &&
+           stats.runs < opts.max_runs_per_round) {
+      struct job_result {
+        point<D> theta;
+        run_result run;
+      };
+      std::vector<std::function<job_result()>> jobs;
+      for (unsigned i = 0; i < opts.particles; ++i) {
+        point<D> theta = sample();
+        jobs.push_back([&target, threshold, theta,
+                        params = make_params(theta),
+                        seed = next_seed++] {
+          return job_result{theta, simulate(params, seed, target,
+                                            threshold)};
+        });
+      }
+
+      peak_times::run_jobs(pool, jobs, [&](job_result const& job) {
+        ++stats.runs;
+        stats.frames += job.run.frames;
+        stats.full_frames += target.frames();
+        if (!job.run.is_accepted) {
+          stats.rejected_early += job.run.frames < target.frames();
+          return;
+        }
+        if (current.size() < opts.particles)
+          current.push_back({job.theta, job.run.distance, 1.0});
+      }, peak_times::result_order::as_submitted);
+    }
+
+    if (!previous.empty()) {
+      for (particle<D>& p : current)
+        p.weight = 1.0 / kernel_density(p.theta);
+    }
+    double total_weight = 0.0;
+    for (particle<D> const& p : current)
+      total_weight += p.weight;
+    for (particle<D>& p : current)
+      p.weight /= total_weight;
+
+    stats.accepted = current.size();
+    calibration.rounds.push_back(stats);
+    if (current.empty())
+      break;
+    previous = std::move(current);
+
+    // The next round's kernel and threshold.
+    for (std::size_t d = 0; d < D; ++d) {
+      double mean = 0.0;
+      for (particle<D> const& p : previous)
+        mean += p.weight * p.theta[d];
+      double variance = 0.0;
+      for (particle<D> const& p : previous)
+        variance += p.weight * (p.theta[d] - mean) * (p.theta[d] - mean);
+      sigma[d] = std::max(std::sqrt(2.0 * variance),
+                          1e-6 * (prior.upper[d] - prior.lower[d]));
+    }
+    std::vector<double> distances;
+    for (particle<D> const& p : previous)
+      distances.push_back(p.distance);
+    std::size_t k = std::min<std::size_t>(
+      distances.size() - 1,
+      static_cast<std::size_t>(opts.quantile * distances.size()));
+    std::ranges::nth_element(distances, distances.begin() + k);
+    threshold = distances[k];
+  }
+
+  calibration.particles = std::move(previous);
+  return calibration;
+}
+
+}
+
+#endif
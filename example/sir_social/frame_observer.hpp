@@ -0,0 +1,109 @@
+#ifndef SIR_SOCIAL_FRAME_OBSERVER_HPP
+#define SIR_SOCIAL_FRAME_OBSERVER_HPP
+
+#include <abmoid/mpsc_queue.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sir_social {
+
+// The counts of one frame copied out of a model.
+struct frame_snapshot {
+  unsigned t = 0;
+  // S, I and R totals.
+  std::array<std::size_t, 3> state{};
+  // group_state::I_count in group order.
+  std::vector<unsigned> I_counts;
+};
+
+// Append the frame as a data file row "t, I_0, I_1, ...".
+inline void format_frame_row(std::string& out, frame_snapshot const& frame) {
+  std::array<char, 16> digits;
+  auto append = [&](unsigned value) {
+    auto [end, ec] = std::to_chars(digits.begin(), digits.end(), value);
+    out.append(digits.begin(), end);
+  };
+  append(frame.t);
+  for (unsigned I_count : frame.I_counts) {
+    out += ", ";
+    append(I_count);
+  }
+  out.push_back('\n');
+}
+
+// Run an observer of each frame on its own thread.
+//
+// Snapshots live in a ring of slots that pass between the model's
+// thread and the observer's thread through a pair of queues, so the
+// model computes the next frame while the observer formats and writes
+// the last one, and nothing is allocated once each slot has held a
+// frame. When the observer falls `capacity` frames behind, publish
+// blocks. Frames are observed in the order they are published and
+// every published frame is observed before the destructor returns.
+class frame_observer {
+  static constexpr std::size_t stop = SIZE_MAX;
+
+  std::vector<frame_snapshot> slots;
+  abmoid::mpsc_queue<std::size_t> free_slots;
+  abmoid::mpsc_queue<std::size_t> full_slots;
+  std::function<void(frame_snapshot const&)> observe;
+  std::jthread thread;
+
+  void run() {
+    std::size_t slot;
+    while (true) {
+      full_slots.pop(slot);
+      if (slot == stop)
+        break;
+      observe(slots[slot]);
+      free_slots.push(slot);
+    }
+  }
+
+public:
+  explicit frame_observer(std::function<void(frame_snapshot const&)> observe,
+                          std::size_t capacity = 64)
+    : slots(std::max<std::size_t>(capacity, 1)),
+      free_slots(slots.size() + 1),
+      full_slots(slots.size() + 1),
+      observe(std::move(observe))
+  {
+    for (std::size_t slot = 0; slot < slots.size(); ++slot)
+      free_slots.push(slot);
+    thread = std::jthread([this] { run(); });
+  }
+
+  frame_observer(frame_observer const&) = delete;
+  frame_observer& operator=(frame_observer const&) = delete;
+
+  ~frame_observer() {
+    full_slots.push(stop);
+  }
+
+  // Copy the counts of the model at frame t.
+  template <typename Model>
+  void publish(unsigned t, Model const& model) {
+    std::size_t slot;
+    free_slots.pop(slot);
+    frame_snapshot& frame = slots[slot];
+    frame.t = t;
+    frame.state = model.get_state();
+    frame.I_counts.clear();
+    for (auto const& group : model.get_group_states())
+      frame.I_counts.push_back(group.I_count);
+    full_slots.push(slot);
+  }
+};
+
+}
+
+#endif
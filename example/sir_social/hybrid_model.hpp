@@ -0,0 +1,211 @@
+#ifndef SIR_SOCIAL_HYBRID_MODEL_HPP
+#define SIR_SOCIAL_HYBRID_MODEL_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "metapopulation_ode.hpp"
+#include "sir_social.hpp"
+
+namespace sir_social {
+
+// When a cohort of a hybrid_model uses mean-field dynamics.
+struct hybrid_policy {
+  // Only cohorts of a single group with at least this many people
+  // may use mean-field dynamics. Smaller cohorts and bridge cohorts
+  // are always agents.
+  unsigned min_population = 10'000;
+  // Such a cohort switches to mean-field dynamics once its group has
+  // this many infected agents, and back to agents once it has at
+  // least one but fewer than half as many infected.
+  unsigned min_infected = 100;
+};
+
+// Simulate small and bridge cohorts as agents and large cohorts with
+// many infected as a metapopulation_ode.
+//
+// Both sides see each group's I / N summed over the two at the start
+// of each frame. Large cohorts start with mean-field dynamics unless
+// they have a few infected, and they switch while the epidemic runs
+// so that an outbreak that is just starting or dying out in a large
+// group stays stochastic. A cohort switching to agents gets fresh
+// infected timers and its recovered are kept as a count.
+// Results depend on the seed.
+class hybrid_model {
+  hybrid_policy policy;
+  agent_model agents;
+  metapopulation_ode mean_field;
+  // Group of each cohort that may switch, or -1.
+  std::vector<int> cohort_group;
+  std::vector<unsigned> cohort_population;
+  std::vector<bool> is_mean_field;
+  // Recovered of agent cohorts that are not agents.
+  std::vector<unsigned> R_counts;
+  std::vector<unsigned> N_g;
+  // Infected agents in each group.
+  std::vector<unsigned> I_agents;
+  // Mean-field infected in each group at the start of the frame.
+  std::vector<unsigned> I_mean_field;
+  std::vector<double> external_I;
+  std::vector<group_name> names;
+  std::vector<group_state> groups;
+
+  static parameters agent_params(parameters params,
+                                 std::vector<bool> const& is_mean_field) {
+    for (std::size_t c = 0; c < params.connections.size(); ++c) {
+      if (is_mean_field[c]) {
+        params.connections[c].N = 0;
+        params.connections[c].I_0 = 0;
+      }
+    }
+    return params;
+  }
+
+  static std::vector<bool> initial_modes(parameters const& params,
+                                         hybrid_policy policy) {
+    std::vector<bool> modes;
+    for (connection_spec const& conn_spec : params.connections) {
+      bool can_switch = conn_spec.groups.size() == 1 &&
+                        conn_spec.N + conn_spec.I_0 >= policy.min_population;
+      bool is_few = conn_spec.I_0 > 0 &&
+                    conn_spec.I_0 < policy.min_infected;
+      modes.push_back(can_switch && !is_few);
+    }
+    return modes;
+  }
+
+  void switch_cohorts() {
+    for (std::size_t c = 0; c < cohort_group.size(); ++c) {
+      if (cohort_group[c] < 0)
+        continue;
+      unsigned g = cohort_group[c];
+
+      if (!is_mean_field[c]) {
+        if (I_agents[g] < policy.min_infected)
+          continue;
+        auto [S, I, R] = agents.remove_cohort(c);
+        I_agents[g] -= I;
+        mean_field.set_cohort(c, {static_cast<double>(S),
+                                  static_cast<double>(I),
+                                  static_cast<double>(R + R_counts[c])});
+        R_counts[c] = 0;
+        is_mean_field[c] = true;
+        continue;
+      }
+
+      auto [S, I, R] = mean_field.get_cohort(c);
+      if (I < 0.5 || I >= policy.min_infected / 2.0)
+        continue;
+      unsigned N = cohort_population[c];
+      unsigned S_count = std::min<unsigned>(std::lround(S), N);
+      unsigned I_count = std::min<unsigned>(std::lround(I), N - S_count);
+      mean_field.set_cohort(c, {0.0, 0.0, 0.0});
+      agents.add_cohort(c, S_count, I_count);
+      I_agents[g] += I_count;
+      R_counts[c] = N - S_count - I_count;
+      is_mean_field[c] = false;
+    }
+  }
+
+  void update_groups() {
+    std::span<double const> I_g = mean_field.get_group_I();
+    for (std::size_t g = 0; g < groups.size(); ++g) {
+      groups[g].I_count = I_agents[g] +
+                          static_cast<unsigned>(std::lround(I_g[g]));
+      groups[g].N_count = N_g[g];
+    }
+  }
+
+public:
+  using seed_type = agent_model::seed_type;
+
+  hybrid_model(parameters const& params, hybrid_policy policy = {},
+               seed_type seed = std::mt19937::default_seed)
+    : policy(policy),
+      agents(agent_params(params, initial_modes(params, policy)), seed),
+      mean_field(params),
+      is_mean_field(initial_modes(params, policy)),
+      R_counts(params.connections.size(), 0)
+  {
+    for (group_params const& g : params.groups) {
+      names.push_back(group_name{g.name});
+      groups.push_back(group_state(g.beta * g.contact_factor));
+    }
+    for (group_state const& state : mean_field.get_group_states())
+      N_g.push_back(state.N_count);
+
+    for (std::size_t c = 0; c < params.connections.size(); ++c) {
+      connection_spec const& conn_spec = params.connections[c];
+      cohort_population.push_back(conn_spec.N + conn_spec.I_0);
+      bool can_switch = conn_spec.groups.size() == 1 &&
+                        cohort_population[c] >= policy.min_population;
+      cohort_group.push_back(-1);
+      if (can_switch) {
+        auto itr = std::ranges::find(names, conn_spec.groups[0],
+                                     &group_name::value);
+        cohort_group.back() = itr - names.begin();
+      }
+      if (!is_mean_field[c])
+        mean_field.set_cohort(c, {0.0, 0.0, 0.0});
+    }
+
+    for (group_state const& state : agents.get_group_states())
+      I_agents.push_back(state.I_count);
+    I_mean_field.resize(groups.size());
+    external_I.resize(groups.size());
+    update_groups();
+  }
+
+  void update() {
+    std::span<double const> I_g = mean_field.get_group_I();
+    for (unsigned g = 0; g < groups.size(); ++g) {
+      I_mean_field[g] = static_cast<unsigned>(std::lround(I_g[g]));
+      agents.set_group_counts(g, I_agents[g] + I_mean_field[g], N_g[g]);
+      external_I[g] = I_agents[g];
+    }
+    mean_field.set_external_I(external_I);
+
+    agents.update();
+    mean_field.update();
+
+    auto const& states = agents.get_group_states();
+    for (unsigned g = 0; g < groups.size(); ++g)
+      I_agents[g] = states.get_values()[g].I_count - I_mean_field[g];
+
+    switch_cohorts();
+    update_groups();
+  }
+
+  // Number of cohorts using mean-field dynamics.
+  std::size_t count_mean_field() const {
+    return std::ranges::count(is_mean_field, true);
+  }
+
+  auto get_state() const {
+    std::array<std::size_t, 3> state = agents.get_state();
+    std::array<std::size_t, 3> mean_field_state = mean_field.get_state();
+    for (unsigned i = 0; i < state.size(); ++i)
+      state[i] += mean_field_state[i];
+    for (unsigned R_count : R_counts)
+      state[2] += R_count;
+    return state;
+  }
+
+  // Return const range of group_name in parameters::groups order.
+  auto const& get_group_names() const {
+    return names;
+  }
+
+  // Return const range of group_state in parameters::groups order.
+  auto const& get_group_states() const {
+    return groups;
+  }
+};
+
+}
+
+#endif
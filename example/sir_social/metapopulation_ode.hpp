@@ -0,0 +1,192 @@
+#ifndef SIR_SOCIAL_METAPOPULATION_ODE_HPP
+#define SIR_SOCIAL_METAPOPULATION_ODE_HPP
+
+#include <abmoid/csr_matrix.hpp>
+#include <abmoid/rk4.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "sir_social.hpp"
+
+namespace sir_social {
+
+// A deterministic mean-field counterpart of agent_model built from
+// the same parameters.
+//
+// Each connection_spec is a cohort with continuous S, I and R counts.
+// A group's I and N are the sums over its member cohorts, found
+// with a sparse mat-vec over the group by cohort membership matrix,
+// and a cohort's force of infection is the sum over its groups
+// found with the transpose. As in agent_model a contact in group g
+// happens with probability I_g / N_g and infects with probability
+// 1 - exp(-beta*_g / 2), the chance an exponential timer rounds to
+// zero, so that is the rate of infection per contact here.
+class metapopulation_ode {
+  double gamma;
+  std::size_t num_cohorts;
+  // Rows are groups, columns are cohorts.
+  abmoid::csr_matrix group_cohorts;
+  abmoid::csr_matrix cohort_groups;
+  std::vector<double> infection_prob;
+  std::vector<double> N_g;
+  // Infected in each group that are simulated elsewhere.
+  std::vector<double> external_I;
+  // S, I and R rows with one column per cohort.
+  std::vector<double> x;
+  unsigned steps_per_frame;
+  abmoid::rk4_workspace workspace;
+  std::vector<group_name> names;
+  std::vector<group_state> groups;
+  // Scratch space for derivative.
+  std::vector<double> I_g;
+  std::vector<double> force_g;
+  std::vector<double> force_c;
+  // Infected of the cohorts here in each group.
+  std::vector<double> cohort_I_g;
+
+  void derivative(std::span<double const> x, std::span<double> dxdt) {
+    std::size_t n = num_cohorts;
+    auto S = x.subspan(0, n);
+    auto I = x.subspan(n, n);
+    group_cohorts.multiply(I, I_g);
+    for (std::size_t g = 0; g < I_g.size(); ++g)
+      force_g[g] = N_g[g] > 0.0 ? infection_prob[g] *
+                                    (I_g[g] + external_I[g]) / N_g[g]
+                                : 0.0;
+    cohort_groups.multiply(force_g, force_c);
+
+    for (std::size_t c = 0; c < n; ++c) {
+      double infections = force_c[c] * S[c];
+      double recoveries = gamma * I[c];
+      dxdt[c] = -infections;
+      dxdt[n + c] = infections - recoveries;
+      dxdt[2 * n + c] = recoveries;
+    }
+  }
+
+  void update_groups() {
+    group_cohorts.multiply(std::span<double const>(x).subspan(num_cohorts,
+                                                              num_cohorts),
+                           cohort_I_g);
+    for (std::size_t g = 0; g < groups.size(); ++g)
+      groups[g].I_count = static_cast<unsigned>(std::lround(cohort_I_g[g]));
+  }
+
+public:
+  explicit metapopulation_ode(parameters const& params,
+                              unsigned steps_per_frame = 10)
+    : gamma(params.gamma),
+      num_cohorts(params.connections.size()),
+      steps_per_frame(steps_per_frame)
+  {
+    std::unordered_map<std::string_view, std::uint32_t> group_index;
+    for (group_params const& g : params.groups) {
+      group_index[g.name] = names.size();
+      names.push_back(group_name{g.name});
+      groups.push_back(group_state(g.beta * g.contact_factor));
+      infection_prob.push_back(-std::expm1(-0.5 * g.beta *
+                                           g.contact_factor));
+    }
+
+    std::vector<abmoid::csr_matrix::entry> entries;
+    x.assign(3 * num_cohorts, 0.0);
+    N_g.assign(params.groups.size(), 0.0);
+    for (std::uint32_t c = 0; c < num_cohorts; ++c) {
+      connection_spec const& conn_spec = params.connections[c];
+      x[c] = conn_spec.N;
+      x[num_cohorts + c] = conn_spec.I_0;
+      for (std::string_view name : conn_spec.groups) {
+        auto itr = group_index.find(name);
+        assert(itr != group_index.end());
+        entries.push_back({itr->second, c, 1.0});
+        N_g[itr->second] += conn_spec.N + conn_spec.I_0;
+      }
+    }
+    group_cohorts = abmoid::csr_matrix(params.groups.size(), num_cohorts,
+                                       std::move(entries));
+    cohort_groups = group_cohorts.transpose();
+
+    I_g.resize(params.groups.size());
+    cohort_I_g.resize(params.groups.size());
+    external_I.assign(params.groups.size(), 0.0);
+    force_g.resize(params.groups.size());
+    force_c.resize(num_cohorts);
+    for (std::size_t g = 0; g < groups.size(); ++g)
+      groups[g].N_count = static_cast<unsigned>(N_g[g]);
+    update_groups();
+  }
+
+  // Advance one frame.
+  void update() {
+    auto fn = [this](abmoid::time_t, std::span<double const> x,
+                     std::span<double> dxdt) {
+      derivative(x, dxdt);
+    };
+    auto ignore = [](std::span<double const>, abmoid::time_t) { };
+    abmoid::rk4(fn, ignore, std::span<double>(x),
+                abmoid::time_step{1.0 / steps_per_frame}, steps_per_frame,
+                workspace);
+    update_groups();
+  }
+
+  // Total S, I and R rounded to whole people.
+  auto get_state() const {
+    std::array<std::size_t, 3> state{};
+    for (unsigned i = 0; i < state.size(); ++i) {
+      double sum = 0.0;
+      for (double value : std::span(x).subspan(i * num_cohorts,
+                                               num_cohorts))
+        sum += value;
+      state[i] = static_cast<std::size_t>(std::llround(sum));
+    }
+    return state;
+  }
+
+  // S, I and R of a cohort, the index of its connection_spec.
+  std::array<double, 3> get_cohort(std::size_t cohort) const {
+    return {x[cohort], x[num_cohorts + cohort], x[2 * num_cohorts + cohort]};
+  }
+
+  void set_cohort(std::size_t cohort, std::array<double, 3> counts) {
+    for (unsigned i = 0; i < counts.size(); ++i)
+      x[i * num_cohorts + cohort] = counts[i];
+    update_groups();
+  }
+
+  // Infected counted in each group's I / N besides the cohorts here,
+  // such as those of an agent model sharing the groups.
+  void set_external_I(std::span<double const> I) {
+    assert(I.size() == external_I.size());
+    std::ranges::copy(I, external_I.begin());
+  }
+
+  // Infected of the cohorts here in each group.
+  std::span<double const> get_group_I() const {
+    return cohort_I_g;
+  }
+
+  // Return const range of group_name in parameters::groups order.
+  auto const& get_group_names() const {
+    return names;
+  }
+
+  // Return const range of group_state in parameters::groups order
+  // with counts of the cohorts here rounded to whole people.
+  auto const& get_group_states() const {
+    return groups;
+  }
+};
+
+}
+
+#endif
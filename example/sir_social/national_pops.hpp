@@ -1,94 +1,94 @@
-{"AF", {"AF", "AFG", "Afghanistan", 42'045'000 }},
-{"DZ", {"DZ", "DZA", "Algeria", 47'400'000 }},
-{"AO", {"AO", "AGO", "Angola", 35'121'734 }},
-{"AR", {"AR", "ARG", "Argentina", 47'067'641 }},
-{"AU", {"AU", "AUS", "Australia", 27'309'396 }},
-{"AZ", {"AZ", "AZE", "Azerbaijan", 10'230'666 }},
-{"BD", {"BD", "BGD", "Bangladesh", 169'828'911 }},
-{"BE", {"BE", "BEL", "Belgium", 11'812'354 }},
-{"BJ", {"BJ", "BEN", "Benin", 12'910'087 }},
-{"BO", {"BO", "BOL", "Bolivia", 11'312'620 }},
-{"BR", {"BR", "BRA", "Brazil", 212'583'750 }},
-{"BF", {"BF", "BFA", "Burkina Faso", 23'409'015 }},
-{"BI", {"BI", "BDI", "Burundi", 12'837'740 }},
-{"KH", {"KH", "KHM", "Cambodia", 17'336'307 }},
-{"CM", {"CM", "CMR", "Cameroon", 28'758'503 }},
-{"CA", {"CA", "CAN", "Canada", 41'528'680 }},
-{"TD", {"TD", "TCD", "Chad", 18'675'547 }},
-{"CL", {"CL", "CHL", "Chile", 20'086'377 }},
-{"CN", {"CN", "CHN", "China", 1'408'280'000 }},
-{"CO", {"CO", "COL", "Colombia", 52'695'952 }},
-{"CU", {"CU", "CUB", "Cuba", 11'089'511 }},
-{"CZ", {"CZ", "CZE", "Czech Republic", 10'909'500 }},
-{"DO", {"DO", "DOM", "Dominican Republic", 10'771'504 }},
-{"EC", {"EC", "ECU", "Ecuador", 16'938'986 }},
-{"EG", {"EG", "EGY", "Egypt", 105'914'499 }},
-{"ET", {"ET", "ETH", "Ethiopia", 109'499'000 }},
-{"FR", {"FR", "FRA", "France", 68'620'000 }},
-{"DE", {"DE", "DEU", "Germany", 83'555'478 }},
-{"GH", {"GH", "GHA", "Ghana", 33'007'618 }},
-{"GR", {"GR", "GRC", "Greece", 10'400'720 }},
-{"GT", {"GT", "GTM", "Guatemala", 17'843'132 }},
-{"GN", {"GN", "GIN", "Guinea", 14'363'931 }},
-{"HT", {"HT", "HTI", "Haiti", 11'867'032 }},
-{"IN", {"IN", "IND", "India", 1'413'324'000 }},
-{"ID", {"ID", "IDN", "Indonesia", 282'477'584 }},
-{"IR", {"IR", "IRN", "Iran", 85'961'000 }},
-{"IQ", {"IQ", "IRQ", "Iraq", 44'414'800 }},
-{"IL", {"IL", "ISR", "Israel", 10'053'500 }},
-{"IT", {"IT", "ITA", "Italy", 58'922'192 }},
-{"CI", {"CI", "CIV", "Ivory Coast", 29'389'150 }},
-{"JP", {"JP", "JPN", "Japan", 123'340'000 }},
-{"JO", {"JO", "JOR", "Jordan", 11'734'000 }},
-{"KZ", {"KZ", "KAZ", "Kazakhstan", 20'333'530 }},
-{"KE", {"KE", "KEN", "Kenya", 52'428'290 }},
-{"MG", {"MG", "MDG", "Madagascar", 30'811'969 }},
-{"MW", {"MW", "MWI", "Malawi", 20'270'568 }},
-{"MY", {"MY", "MYS", "Malaysia", 34'192'800 }},
-{"ML", {"ML", "MLI", "Mali", 22'395'489 }},
-{"MX", {"MX", "MEX", "Mexico", 130'294'079 }},
-{"MA", {"MA", "MAR", "Morocco", 36'828'330 }},
-{"MZ", {"MZ", "MOZ", "Mozambique", 33'244'414 }},
-{"MM", {"MM", "MMR", "Myanmar", 51'316'756 }},
-{"NP", {"NP", "NPL", "Nepal", 29'164'578 }},
-{"NL", {"NL", "NLD", "Netherlands", 18'066'249 }},
-{"NE", {"NE", "NER", "Niger", 26'312'034 }},
-{"NG", {"NG", "NGA", "Nigeria", 223'800'000 }},
-{"KP", {"KP", "PRK", "North Korea", 25'950'000 }},
-{"PK", {"PK", "PAK", "Pakistan", 241'499'431 }},
-{"PG", {"PG", "PNG", "Papua New Guinea", 11'781'559 }},
-{"PE", {"PE", "PER", "Peru", 34'038'457 }},
-{"PH", {"PH", "PHL", "Philippines", 114'123'600 }},
-{"PL", {"PL", "POL", "Poland", 37'454'000 }},
-{"PT", {"PT", "PRT", "Portugal", 10'639'726 }},
-{"RO", {"RO", "ROU", "Romania", 19'064'409 }},
-{"RU", {"RU", "RUS", "Russia", 146'028'325 }},
-{"RW", {"RW", "RWA", "Rwanda", 13'798'561 }},
-{"SA", {"SA", "SAU", "Saudi Arabia", 32'175'224 }},
-{"SN", {"SN", "SEN", "Senegal", 18'126'390 }},
-{"SO", {"SO", "SOM", "Somalia", 19'009'151 }},
-{"ZA", {"ZA", "ZAF", "South Africa", 63'015'904 }},
-{"KR", {"KR", "KOR", "South Korea", 51'183'336 }},
-{"SS", {"SS", "SSD", "South Sudan", 15'254'268 }},
-{"ES", {"ES", "ESP", "Spain", 49'153'849 }},
-{"LK", {"LK", "LKA", "Sri Lanka", 21'763'170 }},
-{"SD", {"SD", "SDN", "Sudan", 50'448'963 }},
-{"SE", {"SE", "SWE", "Sweden", 10'587'696 }},
-{"SY", {"SY", "SYR", "Syria", 24'672'760 }},
-{"TW", {"TW", "TWN", "Taiwan", 23'365'274 }},
-{"TJ", {"TJ", "TJK", "Tajikistan", 10'277'100 }},
-{"TZ", {"TZ", "TZA", "Tanzania", 61'741'120 }},
-{"TH", {"TH", "THA", "Thailand", 65'932'105 }},
-{"TN", {"TN", "TUN", "Tunisia", 11'887'412 }},
-{"TR", {"TR", "TUR", "Turkey", 85'664'944 }},
-{"UG", {"UG", "UGA", "Uganda", 45'905'417 }},
-{"UA", {"UA", "UKR", "Ukraine", 32'962'000 }},
-{"AE", {"AE", "ARE", "United Arab Emirates", 10'678'556 }},
-{"GB", {"GB", "GBR", "United Kingdom", 68'265'209 }},
-{"US", {"US", "USA", "United States", 340'110'988 }},
-{"UZ", {"UZ", "UZB", "Uzbekistan", 37'697'787 }},
-{"VE", {"VE", "VEN", "Venezuela", 28'405'543 }},
-{"VN", {"VN", "VNM", "Vietnam", 101'343'800 }},
-{"YE", {"YE", "YEM", "Yemen", 32'305'264 }},
-{"ZM", {"ZM", "ZMB", "Zambia", 19'610'769 }},
-{"ZW", {"ZW", "ZWE", "Zimbabwe", 16'751'469 }},
+{"AF", "AFG", "Afghanistan", 42'045'000},
+{"DZ", "DZA", "Algeria", 47'400'000},
+{"AO", "AGO", "Angola", 35'121'734},
+{"AR", "ARG", "Argentina", 47'067'641},
+{"AU", "AUS", "Australia", 27'309'396},
+{"AZ", "AZE", "Azerbaijan", 10'230'666},
+{"BD", "BGD", "Bangladesh", 169'828'911},
+{"BE", "BEL", "Belgium", 11'812'354},
+{"BJ", "BEN", "Benin", 12'910'087},
+{"BO", "BOL", "Bolivia", 11'312'620},
+{"BR", "BRA", "Brazil", 212'583'750},
+{"BF", "BFA", "Burkina Faso", 23'409'015},
+{"BI", "BDI", "Burundi", 12'837'740},
+{"KH", "KHM", "Cambodia", 17'336'307},
+{"CM", "CMR", "Cameroon", 28'758'503},
+{"CA", "CAN", "Canada", 41'528'680},
+{"TD", "TCD", "Chad", 18'675'547},
+{"CL", "CHL", "Chile", 20'086'377},
+{"CN", "CHN", "China", 1'408'280'000},
+{"CO", "COL", "Colombia", 52'695'952},
+{"CU", "CUB", "Cuba", 11'089'511},
+{"CZ", "CZE", "Czech Republic", 10'909'500},
+{"DO", "DOM", "Dominican Republic", 10'771'504},
+{"EC", "ECU", "Ecuador", 16'938'986},
+{"EG", "EGY", "Egypt", 105'914'499},
+{"ET", "ETH", "Ethiopia", 109'499'000},
+{"FR", "FRA", "France", 68'620'000},
+{"DE", "DEU", "Germany", 83'555'478},
+{"GH", "GHA", "Ghana", 33'007'618},
+{"GR", "GRC", "Greece", 10'400'720},
+{"GT", "GTM", "Guatemala", 17'843'132},
+{"GN", "GIN", "Guinea", 14'363'931},
+{"HT", "HTI", "Haiti", 11'867'032},
+{"IN", "IND", "India", 1'413'324'000},
+{"ID", "IDN", "Indonesia", 282'477'584},
+{"IR", "IRN", "Iran", 85'961'000},
+{"IQ", "IRQ", "Iraq", 44'414'800},
+{"IL", "ISR", "Israel", 10'053'500},
+{"IT", "ITA", "Italy", 58'922'192},
+{"CI", "CIV", "Ivory Coast", 29'389'150},
+{"JP", "JPN", "Japan", 123'340'000},
+{"JO", "JOR", "Jordan", 11'734'000},
+{"KZ", "KAZ", "Kazakhstan", 20'333'530},
+{"KE", "KEN", "Kenya", 52'428'290},
+{"MG", "MDG", "Madagascar", 30'811'969},
+{"MW", "MWI", "Malawi", 20'270'568},
+{"MY", "MYS", "Malaysia", 34'192'800},
+{"ML", "MLI", "Mali", 22'395'489},
+{"MX", "MEX", "Mexico", 130'294'079},
+{"MA", "MAR", "Morocco", 36'828'330},
+{"MZ", "MOZ", "Mozambique", 33'244'414},
+{"MM", "MMR", "Myanmar", 51'316'756},
+{"NP", "NPL", "Nepal", 29'164'578},
+{"NL", "NLD", "Netherlands", 18'066'249},
+{"NE", "NER", "Niger", 26'312'034},
+{"NG", "NGA", "Nigeria", 223'800'000},
+{"KP", "PRK", "North Korea", 25'950'000},
+{"PK", "PAK", "Pakistan", 241'499'431},
+{"PG", "PNG", "Papua New Guinea", 11'781'559},
+{"PE", "PER", "Peru", 34'038'457},
+{"PH", "PHL", "Philippines", 114'123'600},
+{"PL", "POL", "Poland", 37'454'000},
+{"PT", "PRT", "Portugal", 10'639'726},
+{"RO", "ROU", "Romania", 19'064'409},
+{"RU", "RUS", "Russia", 146'028'325},
+{"RW", "RWA", "Rwanda", 13'798'561},
+{"SA", "SAU", "Saudi Arabia", 32'175'224},
+{"SN", "SEN", "Senegal", 18'126'390},
+{"SO", "SOM", "Somalia", 19'009'151},
+{"ZA", "ZAF", "South Africa", 63'015'904},
+{"KR", "KOR", "South Korea", 51'183'336},
+{"SS", "SSD", "South Sudan", 15'254'268},
+{"ES", "ESP", "Spain", 49'153'849},
+{"LK", "LKA", "Sri Lanka", 21'763'170},
+{"SD", "SDN", "Sudan", 50'448'963},
+{"SE", "SWE", "Sweden", 10'587'696},
+{"SY", "SYR", "Syria", 24'672'760},
+{"TW", "TWN", "Taiwan", 23'365'274},
+{"TJ", "TJK", "Tajikistan", 10'277'100},
+{"TZ", "TZA", "Tanzania", 61'741'120},
+{"TH", "THA", "Thailand", 65'932'105},
+{"TN", "TUN", "Tunisia", 11'887'412},
+{"TR", "TUR", "Turkey", 85'664'944},
+{"UG", "UGA", "Uganda", 45'905'417},
+{"UA", "UKR", "Ukraine", 32'962'000},
+{"AE", "ARE", "United Arab Emirates", 10'678'556},
+{"GB", "GBR", "United Kingdom", 68'265'209},
+{"US", "USA", "United States", 340'110'988},
+{"UZ", "UZB", "Uzbekistan", 37'697'787},
+{"VE", "VEN", "Venezuela", 28'405'543},
+{"VN", "VNM", "Vietnam", 101'343'800},
+{"YE", "YEM", "Yemen", 32'305'264},
+{"ZM", "ZMB", "Zambia", 19'610'769},
+{"ZW", "ZWE", "Zimbabwe", 16'751'469},
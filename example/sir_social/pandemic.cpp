@@ -3,70 +3,63 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
+#include "frame_observer.hpp"
+#include "hybrid_model.hpp"
+#include "metapopulation_ode.hpp"
+#include "partitioned_model.hpp"
+#include "scenario_builder.hpp"
+#include "sci_data.hpp"
+#include "sci_tables.hpp"
 #include "sir_social.hpp"
 
-struct connection_entry {
-  std::string_view code_from;
-  std::string_view code_to;
-  unsigned sci_value;
-  unsigned I_0;  // not scaled
-};
+using sci::connection_entry;
+using sci::national_population_entry;
 
-struct national_population_entry {
-  std::string_view code;
-  std::string_view aux_code;
-  std::string_view name;
-  unsigned population;
-};
+// Do not include countries with small populations.
+constexpr unsigned min_national_population = 50'000'000;
 
-static std::vector<connection_entry> input_country_connections{
-#include "country_connections.hpp"
-};
+// The embedded rows that count toward a scenario found at compile
+// time.
+constinit auto const embedded_connections = [] {
+  constexpr std::size_t count = sci::filter_connections(
+    sci::embedded::connections, sci::embedded::populations_by_code,
+    min_national_population);
+  std::array<connection_entry, count> rows{};
+  sci::filter_connections(sci::embedded::connections,
+                          sci::embedded::populations_by_code,
+                          min_national_population, rows);
+  return rows;
+}();
 
-static std::unordered_map<std::string_view, national_population_entry>
-input_national_pops{
-#include "national_pops.hpp"
+// Connection rows filtered by sci::filter_connections and their
+// populations from the embedded tables or from a file written by
+// sci_convert.out.
+struct input_data {
+  std::span<connection_entry const> connections;
+  sci::population_index const& populations;
 };
 
-unsigned get_national_pop(std::string_view code) {
-  auto itr = input_national_pops.find(code);
-  if (itr == input_national_pops.end())
-    return 0;
-  return itr->second.population;
-}
-
-
 using group_params = sir_social::group_params;
 using connection_spec = sir_social::connection_spec;
 
-void generate_inputs(unsigned sci_scale_factor,
+// Build the scenario for a sci_scale_factor reusing the interned
+// country codes of the builder from the scenarios before.
+void generate_inputs(input_data const& input, unsigned sci_scale_factor,
+                     sir_social::scenario_builder& builder,
                      std::vector<group_params>& groups,
                      std::vector<connection_spec>& connections) {
   constexpr double beta = 0.24;
-  groups.clear();
-  connections.clear();
-
-  auto group = [](std::string_view name) {
-    return sir_social::group_params{
-      .name= name,
-      .beta = beta,
-      .contact_factor = 2
-    };
-  };
-
-  std::vector<std::string_view> group_names;
-  for (connection_entry const& x : input_country_connections) {
-    // Remove duplicates by lexicographical comparison.
-    if (x.code_from > x.code_to)
-      continue;
+  builder.clear();
 
-    // Do not include countries with small populations.
-    unsigned pop = get_national_pop(x.code_from);
-    unsigned pop_to = get_national_pop(x.code_to);
-    constexpr unsigned min_pop = 50'000'000;
-    if (pop < min_pop || pop_to < min_pop)
-      continue;
+  for (connection_entry const& x : input.connections) {
+    unsigned pop = input.populations.get_population(x.code_from);
 
     // Scale and round the SCI values.
     unsigned sci_value = 0;
@@ -78,12 +71,11 @@ void generate_inputs(unsigned sci_scale_factor,
       sci_value = x.sci_value >> sci_scale_factor;
     }
 
-    auto nation_itr = input_national_pops.find(x.code_from);
 #if 0
-    if (x.code_from == x.code_to && nation_itr != input_national_pops.end()) {
-      auto nation = nation_itr->second;
-      std::cout << nation.name << " (I_0 = " << x.I_0 << "): " <<
-                   nation.population << " -> " << sci_value << '\n';
+    auto nation = input.populations.find(x.code_from);
+    if (x.code_from == x.code_to && nation) {
+      std::cout << nation->get_name() << " (I_0 = " << x.I_0 << "): " <<
+                   nation->population << " -> " << sci_value << '\n';
     }
 #endif
 
@@ -92,51 +84,104 @@ void generate_inputs(unsigned sci_scale_factor,
       continue;
 
     // If the codes are the same, that is just the population.
-    group_names.clear();
-    group_names.push_back(x.code_from);
-    if (x.code_from == x.code_to)
-      groups.push_back(group(x.code_from));
-    else
-      group_names.push_back(x.code_to);
-
-    connections.push_back(connection_spec{
-      .groups = group_names,
-      .N = sci_value,
-      .I_0 = x.I_0
-    });
+    if (x.code_from == x.code_to) {
+      builder.add_group(group_params{
+        .name = x.code_from,
+        .beta = beta,
+        .contact_factor = 2
+      });
+      builder.add_cohort({x.code_from}, sci_value, x.I_0);
+    } else {
+      builder.add_cohort({x.code_from, x.code_to}, sci_value, x.I_0);
+    }
   }
 
   // Remove groups with no connections.
   // (Because their population sci_value was large enough
   //  but no connections were.)
-  for (auto itr = groups.begin(); itr != groups.end();) {
-    std::string_view name = itr->name;
-    size_t count = std::count_if(connections.begin(), connections.end(),
-      [&](connection_spec const& conn) {
-        return (conn.groups.size() == 2 &&
-                (conn.groups[0] == name ||
-                 conn.groups[1] == name));
-      });
+  builder.prune_isolated_groups();
+  builder.build(groups, connections);
+}
 
-    if (count == 0) {
-      itr = groups.erase(itr);
-      // Remove the solitary connection node.
-      std::erase_if(connections,
-        [&](connection_spec const& conn) {
-          return conn.groups.size() > 0 &&
-                 conn.groups[0] == name;
-        });
-    } else {
-      ++itr;
+// Print population datasets consisting of row with group names
+// and a row for the total populations for each group.
+template <typename Model>
+void write_header(std::ostream& out, Model const& sir) {
+  out << "# t, ";
+  for (auto [name] : sir.get_group_names())
+    out << name << ", ";
+  out << "\n";
+
+  // Plot total population for each group.
+  out << "# Group population counts.\n";
+  out << "0";
+  for (auto [I_count, N_count, beta_star] : sir.get_group_states())
+    out << ", " << N_count;
+  out << "\n\n\n";
+
+  out << "# Group infected counts.\n";
+}
+
+// Write each frame of the model to data/pandemic.dat while the next
+// one is computed.
+template <typename Model, typename UpdateFn>
+void run_simulation(Model& sir, unsigned total_frames, UpdateFn&& update) {
+  auto infected_data = std::ofstream("data/pandemic.dat");
+  write_header(infected_data, sir);
+  std::cout << "t = 000";
+  std::cout.flush();
+  {
+    std::string row;
+    sir_social::frame_observer observer(
+      [&](sir_social::frame_snapshot const& frame) {
+        row.clear();
+        sir_social::format_frame_row(row, frame);
+        infected_data << row;
+        std::cout << "\b\b\b";  // Erase the previous time digits.
+        std::cout << std::setfill('0') << std::setw(3) << frame.t;
+        std::cout.flush();
+      });
+    for (unsigned t = 0; t < total_frames; ++t) {
+      observer.publish(t, sir);
+      update();
     }
   }
+  std::cout << '\n';
 }
 
-int main() {
+// Run as `d.out` for the agent model or as `d.out hybrid [scale]` for
+// the hybrid agent and mean-field model which can run larger
+// populations with a smaller sci_scale_factor. Either may end with
+// `--data file` to read the connections and populations from a file
+// written by sci_convert.out instead of the embedded tables.
+int main(int argc, char** argv) {
   constexpr unsigned total_frames = 364;
   // Scale the already scaled input population data.
   // (1 / 2)^{sci_scale_factor}
   unsigned sci_scale_factor = 11;
+  std::vector<std::string_view> args(argv + 1, argv + argc);
+  std::optional<sci::mapped_file> data_file;
+  if (args.size() >= 2 && args[args.size() - 2] == "--data") {
+    data_file.emplace(std::string(args.back()));
+    args.resize(args.size() - 2);
+  }
+  bool is_hybrid = !args.empty() && args[0] == "hybrid";
+  if (is_hybrid && args.size() > 1)
+    sci_scale_factor = std::stoul(std::string(args[1]));
+  std::optional<sci::population_index> file_populations;
+  std::vector<connection_entry> file_connections;
+  if (data_file) {
+    file_populations.emplace(data_file->get_populations());
+    file_connections.resize(sci::filter_connections(
+      data_file->get_connections(), *file_populations,
+      min_national_population));
+    sci::filter_connections(data_file->get_connections(), *file_populations,
+                            min_national_population, file_connections);
+  }
+  input_data input = data_file
+    ? input_data{file_connections, *file_populations}
+    : input_data{embedded_connections, sci::embedded::populations_by_code};
+  sir_social::scenario_builder builder;
   std::vector<group_params> groups;
   std::vector<connection_spec> connections;
 
@@ -147,7 +192,7 @@ int main() {
       std::cout << "\nInput error!\n";
       std::exit(1);
     }
-    generate_inputs(sci_scale_factor, groups, connections);
+    generate_inputs(input, sci_scale_factor, builder, groups, connections);
     std::cout << "There are:"
                  "\n\tCountries:\t" << groups.size() <<
                  "\n\tConnections:\t" << connections.size() <<
@@ -162,7 +207,7 @@ int main() {
       break;
   }
 #endif
-  generate_inputs(sci_scale_factor, groups, connections);
+  generate_inputs(input, sci_scale_factor, builder, groups, connections);
 
   std::cout << "\nBegin simulation!\n";
 
@@ -171,38 +216,48 @@ int main() {
     .groups = groups,
     .connections = connections,
   };
-  sir_social::agent_model sir(params);
-
-  auto infected_data = std::ofstream("data/pandemic.dat");
-
-  // Print population datasets consisting of row with group names
-  // and a row for the total populations for each group.
-  infected_data << "# t, ";
-  for (auto [name] : sir.get_group_names())
-    infected_data << name << ", ";
-  infected_data << "\n";
 
-  // Plot total population for each group.
-  infected_data << "# Group population counts.\n";
-  infected_data << "0";
-  for (auto [I_count, N_count, beta_star] : sir.get_group_states())
-    infected_data << ", " << N_count;
-  infected_data << "\n\n\n";
-
-  infected_data << "# Group infected counts.\n";
-  std::cout << "t = 000";
-  std::cout.flush();
-  for (unsigned t = 0; t < total_frames; ++t) {
-    infected_data << t;
-    for (auto const& group : sir.get_group_states())
-      infected_data << ", " << group.I_count;
-    infected_data << '\n';
-    std::cout << "\b\b\b";  // Erase the previous time digits.
-    std::cout << std::setfill('0') << std::setw(3) << t;
-    std::cout.flush();
-    sir.update();
+  // Screen the scenario with the deterministic mean-field
+  // surrogate which runs in a fraction of a second.
+  {
+    sir_social::metapopulation_ode ode(params);
+    auto ode_data = std::ofstream("data/pandemic_ode.dat");
+    write_header(ode_data, ode);
+    std::string row;
+    sir_social::frame_observer observer(
+      [&](sir_social::frame_snapshot const& frame) {
+        row.clear();
+        sir_social::format_frame_row(row, frame);
+        ode_data << row;
+      });
+    for (unsigned t = 0; t < total_frames; ++t) {
+      observer.publish(t, ode);
+      ode.update();
+    }
+    std::cout << "Mean-field surrogate recovered after " <<
+                 total_frames << " frames: " << ode.get_state()[2] << '\n';
   }
-  std::cout << '\n';
+  if (is_hybrid) {
+    sir_social::hybrid_model sir(params);
+    run_simulation(sir, total_frames, [&] { sir.update(); });
+    return 0;
+  }
+
+  // Split the countries into a fixed number of partitions keeping
+  // as few bridge cohorts between them as we can. The partitions,
+  // not the threads, decide the results so they are the same on
+  // any machine. Partitions are spread over the threads.
+  // Spread the threads over the NUMA nodes and pin them so each
+  // partition stays in the memory of the node that runs it.
+  constexpr unsigned partition_count = 8;
+  abmoid::thread_pool pool(std::thread::hardware_concurrency(),
+                           {.mode = abmoid::affinity_policy::scatter});
+  auto partitions = sir_social::partition_groups(params, partition_count);
+  std::cout << "Bridge population cut between " <<
+               partitions.num_partitions << " partitions: " <<
+               sir_social::get_cut(params, partitions) << '\n';
+  sir_social::partitioned_model sir(params, partitions, pool);
+  run_simulation(sir, total_frames, [&] { sir.update(pool); });
 
   // Output max infected count.
 }
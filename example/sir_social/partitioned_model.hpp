@@ -0,0 +1,289 @@
+#ifndef SIR_SOCIAL_PARTITIONED_MODEL_HPP
+#define SIR_SOCIAL_PARTITIONED_MODEL_HPP
+
+#include <abmoid/thread_pool.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <memory>
+#include <numeric>
+#include <ranges>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "sir_social.hpp"
+
+namespace sir_social {
+
+// Assign each group, by its index in parameters::groups, to a
+// partition.
+struct partitioning {
+  unsigned num_partitions = 1;
+  std::vector<unsigned> group_partition;
+};
+
+// Each connection_spec is owned by the partition of its first group.
+// A spec whose groups span partitions is a bridge cohort and its
+// agents are the only ones that change counts in another partition.
+inline unsigned get_owner(partitioning const& p,
+                          std::unordered_map<std::string_view,
+                                             unsigned> const& group_index,
+                          connection_spec const& conn_spec) {
+  assert(!conn_spec.groups.empty());
+  return p.group_partition[group_index.at(conn_spec.groups[0])];
+}
+
+inline std::unordered_map<std::string_view, unsigned>
+make_group_index(parameters const& params) {
+  std::unordered_map<std::string_view, unsigned> group_index;
+  for (unsigned i = 0; i < params.groups.size(); ++i)
+    group_index[params.groups[i].name] = i;
+  return group_index;
+}
+
+// Partition the groups so that the population of bridge cohorts
+// cut between partitions is small while the population owned by
+// each partition stays within `imbalance` of an even split.
+//
+// Groups are placed greedily from largest to smallest into the
+// partition they share the most bridge population with, and then
+// moved one at a time while a move reduces the cut.
+inline partitioning partition_groups(parameters const& params,
+                                     unsigned num_partitions,
+                                     double imbalance = 0.1) {
+  unsigned num_groups = params.groups.size();
+  num_partitions = std::max(1u, std::min(num_partitions, num_groups));
+  auto group_index = make_group_index(params);
+
+  // Population owned by each group and bridge population
+  // shared between groups.
+  std::vector<double> load(num_groups, 0.0);
+  std::vector<std::vector<std::pair<unsigned, double>>> bridges(num_groups);
+  for (connection_spec const& conn_spec : params.connections) {
+    double population = conn_spec.N + conn_spec.I_0;
+    unsigned first = group_index.at(conn_spec.groups[0]);
+    load[first] += population;
+    for (std::string_view name : conn_spec.groups | std::views::drop(1)) {
+      unsigned other = group_index.at(name);
+      bridges[first].push_back({other, population});
+      bridges[other].push_back({first, population});
+    }
+  }
+
+  double total_load = std::accumulate(load.begin(), load.end(), 0.0);
+  double max_load = total_load / num_partitions * (1.0 + imbalance);
+
+  partitioning result{num_partitions,
+                      std::vector<unsigned>(num_groups, num_partitions)};
+  std::vector<unsigned>& assigned = result.group_partition;
+  std::vector<double> partition_load(num_partitions, 0.0);
+
+  // Bridge population between group g and each partition.
+  std::vector<double> shared(num_partitions);
+  auto count_shared = [&](unsigned g) {
+    std::ranges::fill(shared, 0.0);
+    for (auto [other, population] : bridges[g])
+      if (assigned[other] < num_partitions)
+        shared[assigned[other]] += population;
+  };
+
+  std::vector<unsigned> order(num_groups);
+  std::iota(order.begin(), order.end(), 0);
+  std::ranges::stable_sort(order, [&](unsigned a, unsigned b) {
+    return load[a] > load[b];
+  });
+
+  for (unsigned g : order) {
+    count_shared(g);
+    unsigned best = 0;
+    for (unsigned p = 1; p < num_partitions; ++p) {
+      bool fits = partition_load[p] + load[g] <= max_load;
+      bool best_fits = partition_load[best] + load[g] <= max_load;
+      if (fits != best_fits) {
+        if (fits)
+          best = p;
+      } else if (fits ? shared[p] > shared[best] ||
+                        (shared[p] == shared[best] &&
+                         partition_load[p] < partition_load[best])
+                      : partition_load[p] < partition_load[best]) {
+        best = p;
+      }
+    }
+    assigned[g] = best;
+    partition_load[best] += load[g];
+  }
+
+  // Refine by moving single groups while the cut shrinks.
+  for (bool moved = true; moved;) {
+    moved = false;
+    for (unsigned g = 0; g < num_groups; ++g) {
+      count_shared(g);
+      unsigned from = assigned[g];
+      for (unsigned p = 0; p < num_partitions; ++p) {
+        if (p == from || shared[p] <= shared[from] ||
+            partition_load[p] + load[g] > max_load)
+          continue;
+        partition_load[from] -= load[g];
+        partition_load[p] += load[g];
+        assigned[g] = p;
+        moved = true;
+        break;
+      }
+    }
+  }
+
+  return result;
+}
+
+// Bridge population cut by a partitioning.
+inline double get_cut(parameters const& params, partitioning const& p) {
+  auto group_index = make_group_index(params);
+  double cut = 0.0;
+  for (connection_spec const& conn_spec : params.connections) {
+    unsigned owner = get_owner(p, group_index, conn_spec);
+    for (std::string_view name : conn_spec.groups)
+      if (p.group_partition[group_index.at(name)] != owner) {
+        cut += conn_spec.N + conn_spec.I_0;
+        break;
+      }
+  }
+  return cut;
+}
+
+// Run one agent_model per partition in parallel.
+//
+// Each partition simulates the agents of the connection specs it owns
+// with its own generator. Groups that its bridge cohorts reach in
+// other partitions are mirrored locally. At each frame boundary
+// every mirrored group is set to the global counts and afterwards the
+// change in each group's I_count is added back to the global counts,
+// so bridge cohorts see other partitions one frame late.
+// Results depend on the seed and the partitioning but not on the
+// number of threads.
+//
+// Partition i always runs on thread i % pool.size() of the pool it
+// was constructed with, and that thread also constructs it, so with
+// pinned threads its components stay on the thread's NUMA node.
+class partitioned_model {
+  struct partition {
+    agent_model model;
+    // Global group index of each local group.
+    std::vector<unsigned> groups;
+    std::vector<unsigned> I_before;
+  };
+
+  // Allocated by the owning thread.
+  std::vector<std::unique_ptr<partition>> partitions;
+  std::vector<group_name> names;
+  std::vector<group_state> groups;
+
+  template <typename Fn>
+  void for_each_owned(abmoid::thread_pool& pool, Fn&& fn) {
+    pool.for_each_thread([&](unsigned thread_index) {
+      for (std::size_t part = thread_index; part < partitions.size();
+           part += pool.size())
+        fn(part);
+    });
+  }
+
+public:
+  using seed_type = agent_model::seed_type;
+
+  partitioned_model(parameters const& params, partitioning const& p,
+                    abmoid::thread_pool& pool,
+                    seed_type seed = std::mt19937::default_seed) {
+    auto group_index = make_group_index(params);
+
+    std::vector<parameters> partition_params(p.num_partitions);
+    std::vector<std::vector<unsigned>> partition_groups(p.num_partitions);
+    for (parameters& part_params : partition_params)
+      part_params.gamma = params.gamma;
+
+    // Owned groups come first so each partition keeps
+    // parameters::groups order for them.
+    auto add_group = [&](unsigned part, unsigned g) {
+      std::vector<unsigned>& part_groups = partition_groups[part];
+      if (std::ranges::find(part_groups, g) != part_groups.end())
+        return;
+      part_groups.push_back(g);
+      partition_params[part].groups.push_back(params.groups[g]);
+    };
+    for (unsigned g = 0; g < params.groups.size(); ++g)
+      add_group(p.group_partition[g], g);
+    for (connection_spec const& conn_spec : params.connections) {
+      unsigned owner = get_owner(p, group_index, conn_spec);
+      for (std::string_view name : conn_spec.groups)
+        add_group(owner, group_index.at(name));
+      partition_params[owner].connections.push_back(conn_spec);
+    }
+
+    for (group_params const& g : params.groups) {
+      names.push_back(group_name{g.name});
+      groups.push_back(group_state(g.beta * g.contact_factor));
+    }
+
+    partitions.resize(p.num_partitions);
+    for_each_owned(pool, [&](std::size_t part) {
+      partitions[part] = std::make_unique<partition>(partition{
+        agent_model(partition_params[part],
+                    seed + static_cast<seed_type>(part)),
+        std::move(partition_groups[part]),
+        {}});
+    });
+
+    // Sum the counts of groups split across partitions.
+    for (auto const& pt : partitions) {
+      auto const& states = pt->model.get_group_states();
+      for (auto [g, state] : std::views::zip(pt->groups, states)) {
+        groups[g].I_count += state.I_count;
+        groups[g].N_count += state.N_count;
+      }
+    }
+  }
+
+  // The pool must be the one the model was constructed with.
+  void update(abmoid::thread_pool& pool) {
+    for_each_owned(pool, [&](std::size_t part) {
+      partition& pt = *partitions[part];
+      pt.I_before.clear();
+      for (unsigned local = 0; local < pt.groups.size(); ++local) {
+        group_state const& global = groups[pt.groups[local]];
+        pt.model.set_group_counts(local, global.I_count, global.N_count);
+        pt.I_before.push_back(global.I_count);
+      }
+      pt.model.update();
+    });
+
+    for (auto const& pt : partitions) {
+      auto const& states = pt->model.get_group_states();
+      auto pairs = std::views::zip(pt->groups, pt->I_before, states);
+      for (auto [g, I_before, state] : pairs)
+        groups[g].I_count += state.I_count - I_before;
+    }
+  }
+
+  auto get_state() const {
+    std::array<size_t, 3> state{};
+    for (auto const& pt : partitions)
+      for (unsigned i = 0; i < state.size(); ++i)
+        state[i] += pt->model.get_state()[i];
+    return state;
+  }
+
+  // Return const range of group_name in parameters::groups order.
+  auto const& get_group_names() const {
+    return names;
+  }
+
+  // Return const range of group_state in parameters::groups order.
+  auto const& get_group_states() const {
+    return groups;
+  }
+};
+
+}
+
+#endif
@@ -1,6 +1,10 @@
 #include <array>
+#include <atomic>
+#include <functional>
 #include <iostream>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "peak_times.hpp"
 
@@ -11,34 +15,42 @@ int main() {
   constexpr unsigned Br_max = 1005;
   constexpr unsigned Br_step = 25;
 
-  unsigned iterations = 0;
+  constexpr unsigned runs_per_A_N = 100;
+
+  // Submit the whole (A_N, seed) grid at once so the pool stays
+  // busy across values of A_N instead of waiting on the slowest run.
+  // Each run streams its rows to the writer as it goes.
+  std::atomic<unsigned> iterations = 0;
+  using push_row_fn = std::function<void(peak_times::result_row const&)>;
+  std::vector<std::function<void(push_row_fn)>> jobs;
   for (unsigned A_N = 500; A_N <= A_N_max; A_N += A_N_step) {
-    auto run = [A_N](unsigned seed) {
-      unsigned B_N = 10'000 - A_N;
-      peak_times::result_set results;
-
-      for (unsigned Br = 5; Br <= Br_max; Br += Br_step) {
-        peak_times::peak_result peaks = peak_times::run_model(Br, A_N, B_N, seed);
-        results.push_back({
-          .Br = Br,
-          .A_N = A_N,
-          .B_N = B_N,
-          .A_I_max_t = peaks[0].t,
-          .B_I_max_t = peaks[1].t
-        });
-      }
-      return results;
-    };
-
-    auto handle = [&](peak_times::result_set const& results) {
-      peak_times::print_result_set(results);
-      std::cout << "\n\n";  // Begin new dataset.
-      std::cerr << "Finished simulation #" << iterations << '\n';
-      ++iterations;
-    };
-
-    unsigned max_threads = std::thread::hardware_concurrency();
-
-    peak_times::run_experiments(100, max_threads, run, handle);
+    for (unsigned seed = 0; seed < runs_per_A_N; ++seed) {
+      jobs.push_back([A_N, seed, &iterations](push_row_fn push_row) {
+        unsigned B_N = 10'000 - A_N;
+
+        for (unsigned Br = 5; Br <= Br_max; Br += Br_step) {
+          peak_times::peak_result peaks =
+            peak_times::run_model(Br, A_N, B_N, seed);
+          push_row({
+            .Br = Br,
+            .A_N = A_N,
+            .B_N = B_N,
+            .A_I_max_t = peaks[0].t,
+            .B_I_max_t = peaks[1].t
+          });
+        }
+
+        std::cerr << "Finished simulation #" +
+                     std::to_string(iterations++) + '\n';
+      });
+    }
   }
+
+  unsigned max_threads = std::thread::hardware_concurrency();
+  abmoid::work_stealing_pool pool(max_threads);
+
+  // The plots select datasets by index so keep them in grid order.
+  peak_times::result_writer writer(std::cout,
+                                   peak_times::result_order::as_submitted);
+  peak_times::stream_jobs(pool, jobs, writer);
 }
@@ -1,10 +1,25 @@
 #ifndef PEAK_TIMES_HPP
 #define PEAK_TIMES_HPP
 
+#include <abmoid/mpsc_queue.hpp>
+#include <abmoid/work_stealing_pool.hpp>
+
 #include <algorithm>
 #include <array>
-#include <future>
+#include <charconv>
+#include <condition_variable>
+#include <exception>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "sir_social.hpp"
 
@@ -113,6 +128,106 @@ void print_result_set(result_set const& rows) {
     print_result_row(row);
 }
 
+enum class result_order {
+  // Handle each result as soon as its job finishes.
+  as_finished,
+  // Hold results back so they are handled in the order of the jobs.
+  as_submitted
+};
+
+// Jobs
+//  - A range of callables taking no arguments that may differ
+//    in their parameters and run times.
+//  - Each runs in a pool thread so it should be a pure function.
+// HandleResultFn
+//  - void handle(result);
+//  - Runs in calling thread as results arrive.
+// If a job or handle_result throws, no more results are handled and
+// the first exception is rethrown once every submitted job has
+// finished, since the jobs refer to this frame.
+template <std::ranges::input_range Jobs, typename HandleResultFn>
+void run_jobs(abmoid::work_stealing_pool& pool, Jobs&& jobs,
+              HandleResultFn&& handle_result,
+              result_order order = result_order::as_finished) {
+  using job_type = std::ranges::range_value_t<Jobs>;
+  using result_type = std::invoke_result_t<job_type&>;
+  using finished_job = std::pair<std::size_t, std::optional<result_type>>;
+
+  std::mutex mutex;
+  std::condition_variable job_finished;
+  std::vector<finished_job> finished;
+  std::exception_ptr error;
+  // Thrown in the calling thread.
+  std::exception_ptr caller_error;
+
+  std::size_t total_jobs = 0;
+  try {
+    for (auto&& job : jobs) {
+      pool.submit([&, index = total_jobs, job = job_type(job)]() mutable {
+        std::optional<result_type> result;
+        std::exception_ptr job_error;
+        try {
+          result.emplace(job());
+        } catch (...) {
+          job_error = std::current_exception();
+        }
+
+        // Notify under the lock since the calling thread may return
+        // as soon as it sees the last result.
+        std::lock_guard lock(mutex);
+        if (job_error && !error)
+          error = job_error;
+        finished.emplace_back(index, std::move(result));
+        job_finished.notify_one();
+      });
+      ++total_jobs;
+    }
+  } catch (...) {
+    caller_error = std::current_exception();
+  }
+
+  std::vector<finished_job> received;
+  std::map<std::size_t, std::optional<result_type>> held;
+  std::size_t next_index = 0;
+  auto handle = [&](std::optional<result_type>& result) {
+    if (!result || caller_error)
+      return;
+    try {
+      handle_result(std::move(*result));
+    } catch (...) {
+      caller_error = std::current_exception();
+    }
+  };
+  for (std::size_t count = 0; count < total_jobs;) {
+    {
+      std::unique_lock lock(mutex);
+      job_finished.wait(lock, [&] { return !finished.empty(); });
+      std::swap(received, finished);
+    }
+
+    for (auto& [index, result] : received) {
+      ++count;
+      if (order == result_order::as_finished) {
+        handle(result);
+        continue;
+      }
+
+      held.emplace(index, std::move(result));
+      for (auto itr = held.begin();
+           itr != held.end() && itr->first == next_index;
+           itr = held.erase(itr), ++next_index) {
+        handle(itr->second);
+      }
+    }
+    received.clear();
+  }
+
+  if (caller_error)
+    std::rethrow_exception(caller_error);
+  if (error)
+    std::rethrow_exception(error);
+}
+
 // RunExperimentFn
 //  - result_set run(unsigned seed);
 //  - Runs in a thread so it should be a pure function
@@ -122,27 +237,216 @@ void print_result_set(result_set const& rows) {
 template <typename RunExperimentFn, typename HandleResultSetFn>
 void run_experiments(unsigned total_runs, unsigned max_threads,
                      RunExperimentFn&& run,
-                     HandleResultSetFn&& handle_result) {
-  std::vector<std::future<result_set>> result_sets;
-  std::atomic<unsigned> jobs_finished = 0;
-
-  for (unsigned i = 0; i < total_runs;) {
-    unsigned num_runs = std::min(total_runs - i, max_threads);
-    result_sets.clear();
-
-    // Start up a bunch of asynchronous runs.
-    for (unsigned j = 0; j < num_runs; j++) {
-      unsigned seed = i + j;
-      result_sets.push_back(std::async(std::launch::async, run, seed));
+                     HandleResultSetFn&& handle_result,
+                     result_order order = result_order::as_finished) {
+  abmoid::work_stealing_pool pool(max_threads);
+  auto jobs = std::views::iota(0u, total_runs) |
+    std::views::transform([&run](unsigned seed) {
+      return [&run, seed] { return run(seed); };
+    });
+  run_jobs(pool, jobs, handle_result, order);
+}
+
+// Append a row as print_result_row would print it.
+void format_result_row(std::string& out, result_row const& row) {
+  auto const& [Br, A_N, B_N, A_I_max_t, B_I_max_t] = row;
+  std::array<char, 16> digits;
+  for (unsigned value : {Br, A_N, B_N, A_I_max_t, B_I_max_t}) {
+    auto [end, ec] = std::to_chars(digits.begin(), digits.end(), value);
+    out.append(digits.begin(), end);
+    out.push_back(',');
+  }
+  out.back() = '\n';
+}
+
+// Stream the rows of many jobs to an output stream from a
+// writer thread.
+//
+// Jobs push rows into a bounded queue and block while it is full
+// so rows do not pile up when output is slower than the jobs.
+// The rows of each job are written together as a dataset followed
+// by a blank line pair as print_result_set does. The writer keeps
+// the dataset of every job that has started and, for as_submitted,
+// every finished one until those before it are written, so it is
+// up to whoever starts the jobs to bound how far ahead they run, as
+// stream_jobs does.
+class result_writer {
+  struct message {
+    enum kind_t { row, end_of_job, stop };
+
+    kind_t kind;
+    std::size_t job;
+    result_row value;
+  };
+
+  // Write to the stream in chunks of about this many bytes.
+  static constexpr std::size_t flush_size = 1 << 16;
+
+  abmoid::mpsc_queue<message> queue;
+  std::ostream& out;
+  result_order order;
+  std::jthread writer;
+
+  void write() {
+    // Formatted rows of jobs that are still running.
+    std::unordered_map<std::size_t, std::string> running;
+    // Finished datasets held back for as_submitted.
+    std::map<std::size_t, std::string> held;
+    std::size_t next_job = 0;
+    std::string buffer;
+
+    message m;
+    while (true) {
+      queue.pop(m);
+      if (m.kind == message::stop)
+        break;
+
+      if (m.kind == message::row) {
+        format_result_row(running[m.job], m.value);
+        continue;
+      }
+
+      auto node = running.extract(m.job);
+      std::string dataset = node.empty() ? std::string()
+                                         : std::move(node.mapped());
+      dataset += "\n\n";  // Begin new dataset.
+      if (order == result_order::as_finished) {
+        buffer += dataset;
+      } else {
+        held.emplace(m.job, std::move(dataset));
+        for (auto itr = held.begin();
+             itr != held.end() && itr->first == next_job;
+             itr = held.erase(itr), ++next_job) {
+          buffer += itr->second;
+        }
+      }
+
+      if (buffer.size() >= flush_size) {
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+      }
     }
 
-    // For each run, block this thread until it gets the result,
-    // and then handle it.
-    for (auto& future : result_sets)
-      handle_result(future.get());
+    for (auto const& [job, dataset] : held)
+      buffer += dataset;
+    out.write(buffer.data(), buffer.size());
+    out.flush();
+  }
+
+public:
+  explicit result_writer(std::ostream& out,
+                         result_order order = result_order::as_finished,
+                         std::size_t capacity = 1 << 12)
+    : queue(capacity),
+      out(out),
+      order(order),
+      writer([this] { write(); })
+  { }
+
+  result_writer(result_writer const&) = delete;
+  result_writer& operator=(result_writer const&) = delete;
+
+  // Write anything outstanding and join the writer thread.
+  ~result_writer() {
+    queue.push({message::stop, 0, {}});
+  }
+
+  result_order get_order() const {
+    return order;
+  }
+
+  // Jobs are numbered from zero in the order they were submitted.
+  void push(std::size_t job, result_row const& row) {
+    queue.push({message::row, job, row});
+  }
 
-    i += num_runs;
+  void end_job(std::size_t job) {
+    queue.push({message::end_of_job, job, {}});
   }
+};
+
+// Jobs
+//  - A range of callables taking a row sink.
+//      void job(auto&& push_row);
+//      where push_row(result_row const&)
+//  - Each runs in a pool thread so it should be a pure function.
+// Block until every job has ended. If a job throws, its dataset ends
+// with the rows it pushed, no more jobs are submitted and the first
+// exception is rethrown once every submitted job has ended, as with
+// run_jobs.
+//
+// For as_submitted, a job is only submitted once it is fewer than
+// window jobs past the oldest that has not ended, so the writer
+// holds the datasets of at most window jobs however out of order
+// they finish. A window of zero is four jobs per pool thread.
+template <std::ranges::input_range Jobs>
+void stream_jobs(abmoid::work_stealing_pool& pool, Jobs&& jobs,
+                 result_writer& writer, std::size_t window = 0) {
+  using job_type = std::ranges::range_value_t<Jobs>;
+
+  if (window == 0)
+    window = 4 * pool.size();
+  bool is_windowed = writer.get_order() == result_order::as_submitted;
+
+  std::mutex mutex;
+  std::condition_variable job_finished;
+  std::size_t jobs_finished = 0;
+  std::vector<bool> is_finished;
+  std::size_t first_unfinished = 0;
+  std::exception_ptr error;
+  // Thrown in the calling thread.
+  std::exception_ptr caller_error;
+
+  std::size_t total_jobs = 0;
+  try {
+    for (auto&& job : jobs) {
+      {
+        std::unique_lock lock(mutex);
+        if (is_windowed) {
+          job_finished.wait(lock, [&] {
+            return error || total_jobs < first_unfinished + window;
+          });
+        }
+        if (error)
+          break;
+        is_finished.push_back(false);
+      }
+      pool.submit([&, index = total_jobs, job = job_type(job)]() mutable {
+        std::exception_ptr job_error;
+        try {
+          job([&](result_row const& row) { writer.push(index, row); });
+        } catch (...) {
+          job_error = std::current_exception();
+        }
+        writer.end_job(index);
+
+        // Notify under the lock since the calling thread may return
+        // as soon as it sees the last job finish.
+        std::lock_guard lock(mutex);
+        if (job_error && !error)
+          error = job_error;
+        ++jobs_finished;
+        is_finished[index] = true;
+        while (first_unfinished < is_finished.size() &&
+               is_finished[first_unfinished])
+          ++first_unfinished;
+        job_finished.notify_one();
+      });
+      ++total_jobs;
+    }
+  } catch (...) {
+    caller_error = std::current_exception();
+  }
+
+  {
+    std::unique_lock lock(mutex);
+    job_finished.wait(lock, [&] { return jobs_finished == total_jobs; });
+  }
+
+  if (caller_error)
+    std::rethrow_exception(caller_error);
+  if (error)
+    std::rethrow_exception(error);
 }
 
 }
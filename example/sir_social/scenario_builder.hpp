@@ -0,0 +1,196 @@
+#ifndef SIR_SOCIAL_SCENARIO_BUILDER_HPP
+#define SIR_SOCIAL_SCENARIO_BUILDER_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "sir_social.hpp"
+
+namespace sir_social {
+
+// Build the groups and connections of the parameters of a scenario
+// with group names interned to ids. The number of cohorts of more
+// than one group that each group is in is counted as cohorts are
+// added so groups in none of them can be removed in one pass.
+//
+// Clearing keeps the interned names and the storage so one builder
+// can build many scenarios over the same names. Names are not copied
+// and must outlive the builder and the parameters it builds.
+class scenario_builder {
+  static constexpr unsigned no_group = unsigned(-1);
+
+  struct cohort {
+    // The range of the cohort's group ids in cohort_groups.
+    unsigned first;
+    unsigned size;
+    unsigned N;
+    unsigned I_0;
+  };
+
+  std::unordered_map<std::string_view, unsigned> ids;
+  // By id
+  std::vector<std::string_view> names;
+  std::vector<unsigned> degrees;
+  std::vector<unsigned> group_slots;
+
+  std::vector<group_params> groups;
+  std::vector<unsigned> group_ids;
+  std::vector<cohort> cohorts;
+  std::vector<unsigned> cohort_groups;
+
+  // Add the cohort of the ids from first to the end of cohort_groups.
+  void finish_cohort(unsigned first, unsigned N, unsigned I_0) {
+    unsigned size = cohort_groups.size() - first;
+    cohorts.push_back(cohort{.first = first, .size = size,
+                             .N = N, .I_0 = I_0});
+    if (size > 1) {
+      for (unsigned i = first; i < cohort_groups.size(); ++i)
+        ++degrees[cohort_groups[i]];
+    }
+  }
+
+public:
+  scenario_builder() = default;
+
+  unsigned intern(std::string_view name) {
+    auto [itr, did_insert] = ids.try_emplace(name, names.size());
+    if (did_insert) {
+      names.push_back(name);
+      degrees.push_back(0);
+      group_slots.push_back(no_group);
+    }
+    return itr->second;
+  }
+
+  std::string_view get_name(unsigned id) const {
+    return names[id];
+  }
+
+  // The number of cohorts of more than one group with the group.
+  unsigned get_degree(unsigned id) const {
+    return degrees[id];
+  }
+
+  bool is_group(unsigned id) const {
+    return group_slots[id] != no_group;
+  }
+
+  std::size_t get_group_count() const {
+    return groups.size();
+  }
+
+  std::size_t get_cohort_count() const {
+    return cohorts.size();
+  }
+
+  void add_group(group_params const& params) {
+    unsigned id = intern(params.name);
+    assert(!is_group(id) && "should add a group only once");
+    group_slots[id] = groups.size();
+    groups.push_back(params);
+    groups.back().name = names[id];
+    group_ids.push_back(id);
+  }
+
+  void add_cohort(std::span<unsigned const> cohort_ids, unsigned N,
+                  unsigned I_0) {
+    unsigned first = cohort_groups.size();
+    cohort_groups.insert(cohort_groups.end(), cohort_ids.begin(),
+                         cohort_ids.end());
+    finish_cohort(first, N, I_0);
+  }
+
+  void add_cohort(std::initializer_list<std::string_view> cohort_names,
+                  unsigned N, unsigned I_0) {
+    unsigned first = cohort_groups.size();
+    for (std::string_view name : cohort_names)
+      cohort_groups.push_back(intern(name));
+    finish_cohort(first, N, I_0);
+  }
+
+  // Remove the groups that share no cohort with another group along
+  // with their cohorts keeping the order of the rest. Return the
+  // number of groups removed.
+  std::size_t prune_isolated_groups() {
+    auto is_isolated = [&](unsigned id) {
+      return is_group(id) && degrees[id] == 0;
+    };
+
+    // A group with no shared cohort is only in cohorts of itself
+    // so removing them leaves the degrees of the rest unchanged.
+    unsigned next_first = 0;
+    std::size_t cohort_count = 0;
+    for (cohort const& c : cohorts) {
+      if (c.size == 1 && is_isolated(cohort_groups[c.first]))
+        continue;
+      cohort moved = c;
+      moved.first = next_first;
+      std::copy_n(cohort_groups.begin() + c.first, c.size,
+                  cohort_groups.begin() + next_first);
+      next_first += c.size;
+      cohorts[cohort_count++] = moved;
+    }
+    cohorts.resize(cohort_count);
+    cohort_groups.resize(next_first);
+
+    std::size_t group_count = 0;
+    for (std::size_t i = 0; i < groups.size(); ++i) {
+      unsigned id = group_ids[i];
+      if (is_isolated(id)) {
+        group_slots[id] = no_group;
+        continue;
+      }
+      group_slots[id] = group_count;
+      groups[group_count] = groups[i];
+      group_ids[group_count] = id;
+      ++group_count;
+    }
+    std::size_t removed = groups.size() - group_count;
+    groups.resize(group_count);
+    group_ids.resize(group_count);
+    return removed;
+  }
+
+  // Remove the groups and cohorts keeping the interned names.
+  void clear() {
+    std::ranges::fill(degrees, 0);
+    std::ranges::fill(group_slots, no_group);
+    groups.clear();
+    group_ids.clear();
+    cohorts.clear();
+    cohort_groups.clear();
+  }
+
+  // Write the groups and connections in the order they were added
+  // reusing the storage of the vectors.
+  void build(std::vector<group_params>& out_groups,
+             std::vector<connection_spec>& out_connections) const {
+    out_groups.assign(groups.begin(), groups.end());
+    out_connections.resize(cohorts.size());
+    for (std::size_t i = 0; i < cohorts.size(); ++i) {
+      cohort const& c = cohorts[i];
+      connection_spec& spec = out_connections[i];
+      spec.groups.clear();
+      for (unsigned j = 0; j < c.size; ++j)
+        spec.groups.push_back(names[cohort_groups[c.first + j]]);
+      spec.N = c.N;
+      spec.I_0 = c.I_0;
+    }
+  }
+
+  parameters build(double gamma) const {
+    parameters params{.gamma = gamma, .groups = {}, .connections = {}};
+    build(params.groups, params.connections);
+    return params;
+  }
+};
+
+}
+
+#endif
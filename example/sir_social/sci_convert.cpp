@@ -0,0 +1,22 @@
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "sci_data.hpp"
+#include "sci_tables.hpp"
+
+// Write the embedded connection and population tables as a binary
+// file for `d.out --data file` so the data can change without
+// recompiling the simulations.
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " output_file\n";
+    return 1;
+  }
+  std::ofstream out(argv[1], std::ios::binary);
+  sci::write_file(out, sci::embedded::connections,
+                  sci::embedded::populations);
+  std::cout << "Wrote " << std::size(sci::embedded::connections) <<
+               " connections and " << std::size(sci::embedded::populations) <<
+               " populations to " << argv[1] << '\n';
+}
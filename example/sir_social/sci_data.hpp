@@ -0,0 +1,249 @@
+#ifndef SIR_SOCIAL_SCI_DATA_HPP
+#define SIR_SOCIAL_SCI_DATA_HPP
+
+#include <abmoid/mapped_file.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Social Connectedness Index rows between countries and national
+// populations as fixed size records that can be embedded as
+// initializer rows or mapped from a file without copying.
+namespace sci {
+
+// ISO 3166-1 alpha-2 country code.
+struct country_code {
+  char value[2];
+
+  constexpr country_code() = default;
+
+  constexpr country_code(char const (&code)[3])
+    : value{code[0], code[1]}
+  { }
+
+  constexpr std::string_view view() const {
+    return std::string_view(value, 2);
+  }
+
+  constexpr operator std::string_view() const {
+    return view();
+  }
+
+  friend constexpr bool operator==(country_code const& x,
+                                   country_code const& y) {
+    return x.view() == y.view();
+  }
+  friend constexpr std::strong_ordering operator<=>(country_code const& x,
+                                                    country_code const& y) {
+    return x.view() <=> y.view();
+  }
+};
+
+struct connection_entry {
+  country_code code_from;
+  country_code code_to;
+  std::uint32_t sci_value;
+  std::uint32_t I_0;  // not scaled
+};
+
+struct national_population_entry {
+  country_code code;
+  char aux_code[4];
+  char name[34];
+  std::uint32_t population;
+
+  std::string_view get_aux_code() const {
+    return std::string_view(aux_code, ::strnlen(aux_code,
+                                                sizeof(aux_code)));
+  }
+
+  std::string_view get_name() const {
+    return std::string_view(name, ::strnlen(name, sizeof(name)));
+  }
+};
+
+static_assert(std::is_trivially_copyable_v<connection_entry> &&
+              sizeof(connection_entry) == 12);
+static_assert(std::is_trivially_copyable_v<national_population_entry> &&
+              sizeof(national_population_entry) == 44);
+
+// Population records by country code in a table with a slot for each
+// of the 26 * 26 two letter codes, a perfect hash of the codes, so a
+// lookup is one load with no probing. Can be built at compile time,
+// where too many entries or a repeated code fail to compile rather
+// than throw.
+class population_index {
+  static constexpr std::uint16_t empty = 0xffff;
+
+  std::span<national_population_entry const> entries;
+  std::array<std::uint16_t, 26 * 26> slots{};
+
+  static constexpr int slot(std::string_view code) {
+    if (code.size() != 2 || code[0] < 'A' || code[0] > 'Z' ||
+        code[1] < 'A' || code[1] > 'Z')
+      return -1;
+    return (code[0] - 'A') * 26 + (code[1] - 'A');
+  }
+
+public:
+  explicit constexpr population_index(
+      std::span<national_population_entry const> entries)
+    : entries(entries)
+  {
+    if (entries.size() >= empty)
+      throw std::length_error("sci: too many populations to index");
+    slots.fill(empty);
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+      int s = slot(entries[i].code);
+      if (s < 0)
+        continue;
+      if (slots[s] != empty)
+        throw std::invalid_argument("sci: repeated country code " +
+                                    std::string(entries[i].code.view()));
+      slots[s] = static_cast<std::uint16_t>(i);
+    }
+  }
+
+  constexpr national_population_entry const* find(
+      std::string_view code) const {
+    int s = slot(code);
+    if (s < 0 || slots[s] == empty)
+      return nullptr;
+    return &entries[slots[s]];
+  }
+
+  constexpr unsigned get_population(std::string_view code) const {
+    national_population_entry const* entry = find(code);
+    return entry ? entry->population : 0;
+  }
+};
+
+// Copy the rows that count toward a scenario to out, each pair of
+// countries once as code_from <= code_to and only where both have
+// at least min_population, sorted by code. Return the number of such
+// rows, only counting them if out is empty.
+constexpr std::size_t filter_connections(
+    std::span<connection_entry const> rows, population_index const& index,
+    unsigned min_population, std::span<connection_entry> out = {}) {
+  std::size_t count = 0;
+  for (connection_entry const& row : rows) {
+    if (row.code_from > row.code_to ||
+        index.get_population(row.code_from) < min_population ||
+        index.get_population(row.code_to) < min_population)
+      continue;
+    if (!out.empty()) {
+      assert(count < out.size() && "out should have the counted size");
+      out[count] = row;
+    }
+    ++count;
+  }
+  if (!out.empty()) {
+    std::ranges::sort(out.first(count), [](connection_entry const& x,
+                                           connection_entry const& y) {
+      return x.code_from != y.code_from ? x.code_from < y.code_from
+                                        : x.code_to < y.code_to;
+    });
+  }
+  return count;
+}
+
+// The file starts with this header followed by the connection
+// records and then the population records, all in the byte order
+// of the machine that wrote it.
+struct file_header {
+  static constexpr char expected_magic[8] = {'A', 'B', 'M', 'O',
+                                             'I', 'D', 'S', 'C'};
+  static constexpr std::uint32_t current_version = 1;
+
+  char magic[8];
+  std::uint32_t version;
+  // Sizes of the records so a file from a different layout is
+  // rejected.
+  std::uint16_t connection_size;
+  std::uint16_t population_size;
+  std::uint32_t connection_count;
+  std::uint32_t population_count;
+};
+
+inline void write_file(std::ostream& out,
+                       std::span<connection_entry const> connections,
+                       std::span<national_population_entry const> pops) {
+  file_header header{};
+  std::ranges::copy(file_header::expected_magic, header.magic);
+  header.version = file_header::current_version;
+  header.connection_size = sizeof(connection_entry);
+  header.population_size = sizeof(national_population_entry);
+  header.connection_count = connections.size();
+  header.population_count = pops.size();
+  out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  out.write(reinterpret_cast<char const*>(connections.data()),
+            connections.size_bytes());
+  out.write(reinterpret_cast<char const*>(pops.data()), pops.size_bytes());
+  if (!out)
+    throw std::runtime_error("sci: write failed");
+}
+
+// A file written by write_file mapped read only.
+class mapped_file {
+  abmoid::mapped_file file;
+  std::span<connection_entry const> connections;
+  std::span<national_population_entry const> populations;
+
+public:
+  explicit mapped_file(std::string const& path)
+    : file(path, "sci", sizeof(file_header))
+  {
+    std::span<std::byte const> bytes = file.get_bytes();
+    file_header header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    std::size_t expected_size =
+      sizeof(header) +
+      std::size_t(header.connection_count) * sizeof(connection_entry) +
+      std::size_t(header.population_count) *
+        sizeof(national_population_entry);
+    if (!std::ranges::equal(header.magic, file_header::expected_magic))
+      file.fail("not an SCI data file");
+    if (header.version != file_header::current_version)
+      file.fail("unsupported version");
+    if (header.connection_size != sizeof(connection_entry) ||
+        header.population_size != sizeof(national_population_entry))
+      file.fail("unsupported record layout");
+    if (bytes.size() < expected_size)
+      file.fail("truncated");
+    if (bytes.size() > expected_size)
+      file.fail("size mismatch");
+
+    // The header keeps the records 4 byte aligned.
+    auto records = reinterpret_cast<char const*>(bytes.data()) +
+                   sizeof(header);
+    connections = {reinterpret_cast<connection_entry const*>(records),
+                   header.connection_count};
+    records += connections.size_bytes();
+    populations = {
+      reinterpret_cast<national_population_entry const*>(records),
+      header.population_count};
+  }
+
+  std::span<connection_entry const> get_connections() const {
+    return connections;
+  }
+
+  std::span<national_population_entry const> get_populations() const {
+    return populations;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef SIR_SOCIAL_SCI_TABLES_HPP
+#define SIR_SOCIAL_SCI_TABLES_HPP
+
+#include "sci_data.hpp"
+
+// The connection and population rows embedded at compile time.
+namespace sci::embedded {
+
+inline constexpr connection_entry connections[] = {
+#include "country_connections.hpp"
+};
+
+inline constexpr national_population_entry populations[] = {
+#include "national_pops.hpp"
+};
+
+inline constexpr population_index populations_by_code{populations};
+
+}
+
+#endif
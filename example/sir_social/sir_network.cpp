@@ -1,6 +1,8 @@
 #include <array>
 #include <fstream>
+#include <string>
 
+#include "frame_observer.hpp"
 #include "sir_social.hpp"
 
 int main() {
@@ -102,11 +104,15 @@ int main() {
   infected_data << "\n\n\n";
 
   infected_data << "# Group infected counts.\n";
+  std::string row;
+  sir_social::frame_observer observer(
+    [&](sir_social::frame_snapshot const& frame) {
+      row.clear();
+      sir_social::format_frame_row(row, frame);
+      infected_data << row;
+    });
   for (unsigned t = 0; t < total_frames; ++t) {
     sir.update();
-    infected_data << t;
-    for (auto const& group : sir.get_group_states())
-      infected_data << ", " << group.I_count;
-    infected_data << '\n';
+    observer.publish(t, sir);
   }
 }
@@ -3,16 +3,32 @@
 
 #include <abmoid/agent.hpp>
 #include <abmoid/agent_component.hpp>
+#include <abmoid/bernoulli_skip.hpp>
+#include <abmoid/contact_test.hpp>
+#include <abmoid/count_down.hpp>
+#include <abmoid/thread_pool.hpp>
 
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <ostream>
 #include <random>
 #include <ranges>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <string_view>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "snapshot.hpp"
+
 namespace sir_social {
 struct group_params {
   std::string_view name;
@@ -43,6 +59,9 @@ using social_group = abmoid::agent_t<social_group_tag>;
 struct susceptible_state {
   // Frames until infected;
   unsigned timer = 0;
+  // Index of the connection_spec the person came from
+  // which decides the groups they belong to.
+  unsigned cohort = 0;
 };
 struct recovered_state { };
 
@@ -68,12 +87,20 @@ struct group_name {
   std::string_view value;
 };
 
+// Members of a social group in the order they were added.
+struct group_members {
+  std::vector<person> value;
+  // How many of them are susceptible.
+  unsigned S_count = 0;
+};
+
 // Track social group connections and relevant
 // simulation data.
 class social_group_connections {
 
   abmoid::agent_component<group_name, social_group> group_names;
   abmoid::agent_component<group_state, social_group> groups;
+  abmoid::agent_component<group_members, social_group> members;
   std::unordered_set<std::pair<social_group, person>> connections;
   std::unordered_map<std::string_view, social_group> name_lookup;
 
@@ -83,6 +110,12 @@ class social_group_connections {
     return *group_itr;
   }
 
+  group_members& get_members_helper(social_group g) {
+    auto members_itr = members.find(g);
+    assert(members_itr != members.end());
+    return *members_itr;
+  }
+
 public:
   social_group_connections() = default;
 
@@ -94,11 +127,22 @@ public:
       .get_group_state_helper(g);
   }
 
+  std::vector<person> const& get_members(social_group g) const {
+    return const_cast<social_group_connections&>(*this)
+      .get_members_helper(g).value;
+  }
+
+  unsigned get_S_count(social_group g) const {
+    return const_cast<social_group_connections&>(*this)
+      .get_members_helper(g).S_count;
+  }
+
   void init_group(social_group g, group_params const& params) {
     name_lookup[params.name] = g;
     double beta_star = params.beta * params.contact_factor;
     group_names.create(g, group_name(params.name));
     groups.create(g, group_state(beta_star));
+    members.create(g, group_members{});
   }
 
   social_group get(std::string_view name) const {
@@ -118,6 +162,10 @@ public:
     // Add an entry to the set.
     auto [itr, did_insert] = connections.insert({g, p});
     assert(did_insert && "should add connection only once");
+    group_members& m = get_members_helper(g);
+    m.value.push_back(p);
+    if (!is_infected)
+      ++m.S_count;
 
     // Get the group data associated with the group agent.
     group_state& group = get_group_state_helper(g);
@@ -134,25 +182,158 @@ public:
     return add(p, get(group_name), is_infected);
   }
 
+  // Remove every member from every group keeping the groups.
+  void clear_members() {
+    connections.clear();
+    for (group_members& m : members) {
+      m.value.clear();
+      m.S_count = 0;
+    }
+    for (group_state& group : groups) {
+      group.I_count = 0;
+      group.N_count = 0;
+    }
+  }
+
+  // Make room for count more memberships over every group.
+  void reserve(std::size_t count) {
+    connections.reserve(connections.size() + count);
+  }
+
+  // Add many people to the group at index, S_count of them
+  // susceptible and I_count of them infected.
+  void add_members(unsigned index, std::span<person const> new_members,
+                   unsigned S_count, unsigned I_count) {
+    social_group g = groups.get_agent(index);
+    group_state& group = *(groups.begin() + index);
+    for (person p : new_members) {
+      [[maybe_unused]] auto [itr, did_insert] = connections.insert({g, p});
+      assert(did_insert && "should add connection only once");
+    }
+    group_members& m = get_members_helper(g);
+    m.value.insert(m.value.end(), new_members.begin(), new_members.end());
+    m.S_count += S_count;
+    group.N_count += new_members.size();
+    group.I_count += I_count;
+  }
+
+  // Remove people from the group at index keeping the order of the
+  // remaining members. is_susceptible(p) and is_infected(p) tell
+  // which counts to lower.
+  template <typename IsSusceptible, typename IsInfected>
+  void remove(unsigned index, std::unordered_set<person> const& removed,
+              IsSusceptible&& is_susceptible, IsInfected&& is_infected) {
+    social_group g = groups.get_agent(index);
+    group_state& group = *(groups.begin() + index);
+    group_members& m = get_members_helper(g);
+    std::erase_if(m.value, [&](person p) {
+      if (!removed.contains(p))
+        return false;
+      connections.erase({g, p});
+      --group.N_count;
+      if (is_susceptible(p))
+        --m.S_count;
+      else if (is_infected(p))
+        --group.I_count;
+      return true;
+    });
+  }
+
   // For a person changing infected state, update
   // the groups counts for each group.
   // We assume `is_infected` is not the same as
-  // the current state.
+  // the current state and that only the susceptible
+  // become infected.
   void update(person p, bool is_infected) {
-    for (auto itr = groups.begin(); itr != groups.end(); ++itr) {
-      social_group g = groups.get_agent(itr);
-      if (connections.contains({g, p})) {
-        group_state& group = *itr;
-        if (is_infected)
-          ++group.I_count;
-        else
-          --group.I_count;
+    for_each_group(p, [&](unsigned index, social_group g) {
+      group_state& group = *(groups.begin() + index);
+      if (is_infected) {
+        ++group.I_count;
+        --get_members_helper(g).S_count;
+      } else {
+        --group.I_count;
       }
+    });
+  }
+
+  // Call fn(index, g) for each group g the person belongs to where
+  // index is the position of the group in get_group_states().
+  template <typename Fn>
+  void for_each_group(person p, Fn&& fn) const {
+    for (unsigned index = 0; index < groups.size(); ++index) {
+      social_group g = groups.get_agent(index);
+      if (connections.contains({g, p}))
+        fn(index, g);
     }
   }
+
+  // Apply a change in infected count accumulated elsewhere
+  // to the group at index.
+  void add_I_count(unsigned index, int I_delta) {
+    group_state& group = *(groups.begin() + index);
+    group.I_count += I_delta;
+  }
+
+  // Apply a change in susceptible members to the group at index.
+  void add_S_count(unsigned index, int S_delta) {
+    social_group g = groups.get_agent(index);
+    get_members_helper(g).S_count += S_delta;
+  }
+
+  void set_counts(unsigned index, unsigned I_count, unsigned N_count) {
+    group_state& group = *(groups.begin() + index);
+    group.I_count = I_count;
+    group.N_count = N_count;
+  }
+};
+
+enum class contact_direction {
+  // Sweep the susceptibles testing each for contact.
+  pull,
+  // Sweep the members of the group testing each for contact.
+  push
+};
+
+// Choose per group per frame how update_S finds contacts
+// in the manner of direction-optimizing BFS.
+//
+// Pushing spends I_g trials on the members of the group, each a
+// lookup in S, but only S_g / N_g of them find someone still
+// susceptible so it costs about I_g * N_g / S_g. Pulling spends
+// (I_g / N_g) * |S| trials of the shared sweep of all susceptibles,
+// each a membership test. A group pushes while
+// N_g^2 < alpha * S_g * |S| and turns to pulling as its own
+// susceptibles run out. A group with no infected has no contacts to
+// find and pulls, which draws nothing.
+struct direction_policy {
+  enum mode_t { automatic, always_pull, always_push };
+
+  mode_t mode = automatic;
+  double alpha = 1.0;
+
+  contact_direction operator()(group_state const& group, unsigned S_g,
+                               std::size_t S_size) const {
+    if (mode == always_pull)
+      return contact_direction::pull;
+    if (mode == always_push)
+      return contact_direction::push;
+
+    double N_g = static_cast<double>(group.N_count);
+    if (group.I_count > 0 &&
+        N_g * N_g < alpha * static_cast<double>(S_g) *
+                    static_cast<double>(S_size))
+      return contact_direction::push;
+    return contact_direction::pull;
+  }
 };
 
 class agent_model {
+  // Per group state for skipping to the next contact in update_S.
+  struct contact_stream {
+    abmoid::bernoulli_skip skip;
+    std::size_t next;
+  };
+
   double gamma;
   abmoid::population_t<person> people;
   abmoid::population_t<social_group> social_groups;
@@ -161,8 +342,44 @@ class agent_model {
   abmoid::agent_component<infected_state, person> I;
   abmoid::agent_component<recovered_state, person> R;
   social_group_connections connections;
+  direction_policy choose_direction;
+  std::vector<contact_stream> contacts;
+  std::vector<contact_direction> directions;
+  // Indices of I whose timers expired this frame.
+  std::vector<std::uint32_t> expired;
 
-  void init(parameters const& params) {
+  // Transitions drawn by one block of a parallel update.
+  struct block_transitions {
+    std::mt19937::result_type seed;
+    // Newly infected with their initial timers.
+    std::vector<std::pair<person, unsigned>> infected;
+    std::vector<person> recovered;
+    // Scratch space for count_down and contact_test.
+    std::vector<std::uint32_t> indices;
+  };
+
+  // Agents per block of a parallel update. The blocks, not the
+  // threads, own the random number streams so results do not
+  // depend on the number of threads.
+  static constexpr std::size_t block_size = 1 << 13;
+
+  // Expected contacts per susceptible per frame above which the
+  // parallel update tests every susceptible with contact_test rather
+  // than skipping ahead to the contacts in each group.
+  static constexpr double dense_contact_rate = 1.0 / 16;
+
+  std::vector<double> contact_probs;
+  // Group indices of each cohort.
+  std::vector<std::vector<unsigned>> cohort_groups;
+  // People of each cohort in any state.
+  std::vector<std::vector<person>> cohort_people;
+  // Probability that a member of each cohort is infected this frame.
+  std::vector<std::uint32_t> cohort_thresholds;
+  std::vector<block_transitions> blocks;
+  // Changes to group_state::I_count per thread per group.
+  std::vector<std::vector<int>> I_deltas;
+
+  void init_groups(parameters const& params) {
     S.clear();
     I.clear();
     R.clear();
@@ -171,88 +388,277 @@ class agent_model {
     for (auto const& [g, params] : pairs)
       connections.init_group(g, params);
 
+    cohort_groups.clear();
+    cohort_people.assign(params.connections.size(), {});
     for (connection_spec const& conn_spec : params.connections) {
-        for (unsigned i = 0; i < conn_spec.N; ++i) {
-          person p = people.push_back();
-          S.create(p, susceptible_state{0});
-          for (std::string_view group_name : conn_spec.groups)
-            connections.add(p, group_name, /*is_infected=*/false);
-        }
-        for (unsigned i = 0; i < conn_spec.I_0; ++i) {
-          person p = people.push_back();
-          assign_I(p);
-          for (std::string_view group_name : conn_spec.groups)
-            connections.add(p, group_name, /*is_infected=*/true);
-        }
+      std::vector<unsigned>& group_indices = cohort_groups.emplace_back();
+      for (std::string_view group_name : conn_spec.groups) {
+        auto itr = std::ranges::find(params.groups, group_name,
+                                     &group_params::name);
+        assert(itr != params.groups.end());
+        group_indices.push_back(itr - params.groups.begin());
+      }
+    }
+  }
+
+  void init(parameters const& params) {
+    init_groups(params);
+    for (unsigned cohort = 0; cohort < params.connections.size(); ++cohort) {
+      connection_spec const& conn_spec = params.connections[cohort];
+      add_cohort(cohort, conn_spec.N, conn_spec.I_0);
+    }
+  }
+
+  // Add the people of every cohort as init(params) does, with the
+  // same ids, order and infected timers, using the threads of the
+  // pool.
+  //
+  // The range of each cohort in the people, in S, in I and in the
+  // members of each of its groups is found by prefix sums, which also
+  // reduce the group counts. The timers are drawn in the same order
+  // as add_cohort draws them, then the people are written to their
+  // ranges in blocks and finally the lookups of S, I and the group
+  // memberships, which are hashed, are built at the same time.
+  void init(parameters const& params, abmoid::thread_pool& pool) {
+    init_groups(params);
+
+    std::size_t cohort_count = params.connections.size();
+    std::vector<std::size_t> person_first(cohort_count + 1, 0);
+    std::vector<std::size_t> S_first(cohort_count + 1, 0);
+    std::vector<std::size_t> I_first(cohort_count + 1, 0);
+    // Offset of each cohort in the members of each of its groups.
+    std::vector<std::vector<std::size_t>> member_first(cohort_count);
+    std::vector<std::size_t> N_counts(params.groups.size(), 0);
+    std::vector<unsigned> S_counts(params.groups.size(), 0);
+    std::vector<unsigned> I_counts(params.groups.size(), 0);
+    for (std::size_t cohort = 0; cohort < cohort_count; ++cohort) {
+      unsigned N = params.connections[cohort].N;
+      unsigned I_0 = params.connections[cohort].I_0;
+      person_first[cohort + 1] = person_first[cohort] + N + I_0;
+      S_first[cohort + 1] = S_first[cohort] + N;
+      I_first[cohort + 1] = I_first[cohort] + I_0;
+      for (unsigned index : cohort_groups[cohort]) {
+        member_first[cohort].push_back(N_counts[index]);
+        N_counts[index] += N + I_0;
+        S_counts[index] += N;
+        I_counts[index] += I_0;
+      }
+      cohort_people[cohort].resize(N + I_0);
     }
+
+    std::vector<infected_state> I_values;
+    I_values.reserve(I_first.back());
+    for (std::size_t i = 0; i < I_first.back(); ++i)
+      I_values.push_back(infected_state{gen_I_timer(gen)});
+
+    std::vector<person> S_agents(S_first.back());
+    std::vector<susceptible_state> S_values(S_first.back());
+    std::vector<person> I_agents(I_first.back());
+    std::vector<std::vector<person>> members(params.groups.size());
+    for (unsigned index = 0; index < members.size(); ++index)
+      members[index].resize(N_counts[index]);
+
+    std::size_t person_count = person_first.back();
+    auto first_person = people.append(person_count);
+    std::size_t num_blocks = (person_count + block_size - 1) / block_size;
+    pool.parallel_for(num_blocks, [&](std::size_t block, unsigned) {
+      std::size_t first = block * block_size;
+      std::size_t last = std::min(first + block_size, person_count);
+      // The last cohort starting at or before the block, skipping
+      // empty ones.
+      std::size_t cohort =
+        std::ranges::upper_bound(person_first, first) -
+        person_first.begin() - 1;
+      for (std::size_t k = first; k < last; ++k) {
+        while (k >= person_first[cohort + 1])
+          ++cohort;
+        person p = first_person[k];
+        std::size_t i = k - person_first[cohort];
+        unsigned N = params.connections[cohort].N;
+        if (i < N) {
+          S_agents[S_first[cohort] + i] = p;
+          S_values[S_first[cohort] + i] =
+            susceptible_state{0, static_cast<unsigned>(cohort)};
+        } else {
+          I_agents[I_first[cohort] + i - N] = p;
+        }
+        auto offsets = std::views::zip(cohort_groups[cohort],
+                                       member_first[cohort]);
+        for (auto [index, offset] : offsets)
+          members[index][offset + i] = p;
+        cohort_people[cohort][i] = p;
+      }
+    });
+
+    pool.parallel_for(3, [&](std::size_t task, unsigned) {
+      if (task == 0) {
+        S.append(S_agents, S_values);
+      } else if (task == 1) {
+        I.append(I_agents, I_values);
+      } else {
+        std::size_t membership_count = 0;
+        for (std::vector<person> const& group_members : members)
+          membership_count += group_members.size();
+        connections.reserve(membership_count);
+        for (unsigned index = 0; index < members.size(); ++index)
+          connections.add_members(index, members[index], S_counts[index],
+                                  I_counts[index]);
+      }
+    });
   }
 
+  // The first section of a snapshot.
+  struct snapshot_info {
+    static constexpr std::uint32_t current_version = 1;
+
+    std::uint32_t version;
+    std::uint32_t group_count;
+    std::uint64_t cohort_count;
+    std::uint64_t population_size;
+  };
+
   double gen_uniform_random() {
     return std::uniform_real_distribution<double>()(gen);
   }
 
+  template <typename Engine>
+  unsigned gen_I_timer(Engine& engine) const {
+    double rand = std::exponential_distribution<>(gamma)(engine);
+    return static_cast<unsigned>(std::round(rand));
+  }
+
   void assign_I(person a) {
-    double rand = std::exponential_distribution<>(gamma)(gen);
-    unsigned initial_timer = static_cast<unsigned>(std::round(rand));
+    unsigned initial_timer = gen_I_timer(gen);
 
     I.create(a, infected_state{initial_timer});
     connections.update(a, /*is_infected=*/true);
   }
 
-  void update_S() {
-    // Iterate susceptibles and possibly make sick.
-    for (auto itr = S.begin(); itr != S.end();) {
-      // Count the number of nodes connected to this susceptible person.
-      unsigned total_count = 0;
-      unsigned infected_count = 0;
-      auto infected_itr = S.end();
-      susceptible_state s = *itr;
-      if (s.timer == 1) {
-        infected_itr = itr;
-      } else if (s.timer > 1) {
-        --s.timer;
-      } else {
-        // TODO Possibly handle agent counts in intersection of groups.
-        for (social_group g : social_groups) {
-          if (connections.contains(g, S.get_agent(itr))) {
-            auto [I_g, N_g, beta_star_g] = connections.get_group_state(g);
-            double I_over_N = static_cast<double>(I_g) /
-                              static_cast<double>(N_g);
-
-            if (gen_uniform_random() < I_over_N) {
-              double rand =
-                std::exponential_distribution<>(beta_star_g)(gen);
-              s.timer = static_cast<unsigned>(std::round(rand));
-              if (s.timer == 0) {
-                infected_itr = itr;
-                break;
-              }
-            }
+  abmoid::bernoulli_skip contact_skip(social_group g) const {
+    auto [I_g, N_g, beta_star_g] = connections.get_group_state(g);
+    double I_over_N = static_cast<double>(I_g) /
+                      static_cast<double>(N_g);
+    return abmoid::bernoulli_skip(I_over_N);
+  }
+
+  // Given contact in group g, roll the dice for infection.
+  // A contact that does not infect immediately is not carried over
+  // to the next frame so susceptible timers stay at zero.
+  template <typename Engine>
+  bool is_infected_by_contact(social_group g, Engine& engine) const {
+    double beta_star_g = connections.get_group_state(g).beta_star;
+    double rand = std::exponential_distribution<>(beta_star_g)(engine);
+    return static_cast<unsigned>(std::round(rand)) == 0;
+  }
+
+  // Test the members of a group for contact skipping
+  // ahead to each contact. Each infection raises I/N so the skip is
+  // redrawn from the next member.
+  void push_S(social_group g) {
+    std::vector<person> const& members = connections.get_members(g);
+    abmoid::bernoulli_skip skip = contact_skip(g);
+    for (std::size_t i = skip.next(gen, 0); i < members.size();
+         i = skip.next(gen, i + 1)) {
+      person p = members[i];
+      auto itr = S.find(p);
+      if (itr == S.end() || !is_infected_by_contact(g, gen))
+        continue;
+
+      assign_I(p);
+      S.erase(itr);
+      skip = contact_skip(g);
+    }
+  }
+
+  // Sweep the susceptibles testing the groups that were not pushed.
+  void pull_S() {
+    // Rather than rolling the dice for every susceptible in every
+    // group, each group keeps a stream of Bernoulli trials over the
+    // visits of the sweep and skips ahead to its next contact.
+    // The trials are memoryless so when a new infection changes
+    // I/N for a group we simply redraw its stream from the next visit.
+    constexpr auto never = abmoid::bernoulli_skip::never;
+
+    contacts.clear();
+    for (auto [g, direction] : std::views::zip(social_groups, directions)) {
+      abmoid::bernoulli_skip skip;
+      if (direction == contact_direction::pull)
+        skip = contact_skip(g);
+      contacts.push_back({skip, skip.next(gen, 0)});
+    }
+
+    // Each visit either moves to the next position or, when the
+    // agent is erased, revisits the position with the agent swapped
+    // in from the back, so there are always S.size() - pos visits left.
+    std::size_t visit = 0;
+    std::size_t pos = 0;
+    while (true) {
+      std::size_t next = never;
+      for (contact_stream const& c : contacts)
+        next = std::min(next, c.next);
+      if (next == never || next - visit >= S.size() - pos)
+        break;
+
+      pos += next - visit;
+      visit = next;
+      auto itr = S.begin() + pos;
+      person p = S.get_agent(itr);
+
+      // TODO Possibly handle agent counts in intersection of groups.
+      bool is_infected = false;
+      for (auto [c, g] : std::views::zip(contacts, social_groups)) {
+        if (c.next != visit)
+          continue;
+        c.next = c.skip.next(gen, visit + 1);
+        if (!is_infected && connections.contains(g, p))
+          is_infected = is_infected_by_contact(g, gen);
+      }
+
+      if (is_infected) {
+        assign_I(p);
+        S.erase(itr);
+        auto pairs = std::views::zip(contacts, social_groups, directions);
+        for (auto [c, g, direction] : pairs) {
+          if (direction == contact_direction::pull &&
+              connections.contains(g, p)) {
+            c.skip = contact_skip(g);
+            c.next = c.skip.next(gen, visit + 1);
           }
         }
+      } else {
+        ++pos;
       }
+      ++visit;
+    }
+  }
 
-      if (infected_itr != S.end()) {
-        assign_I(S.get_agent(itr));
-        itr = S.erase(itr);
-      } else
-        ++itr;
+  void update_S() {
+    // Each susceptible tests each of its groups once per frame
+    // either way so the directions may be mixed freely.
+    directions.clear();
+    for (social_group g : social_groups) {
+      directions.push_back(
+        choose_direction(connections.get_group_state(g),
+                         connections.get_S_count(g), S.size()));
     }
+
+    for (auto [g, direction] : std::views::zip(social_groups, directions))
+      if (direction == contact_direction::push)
+        push_S(g);
+
+    pull_S();
   }
 
   void update_I() {
-    // Iterate infecteds updating timer and possibly make recovered.
-    for (auto itr = I.begin(); itr != I.end();) {
-      infected_state& state = *itr;
-      if (state.timer == 0) {
-        person p = I.get_agent(itr);
-        R.create(p);
-        I.erase(itr);
-        connections.update(p, /*is_infected=*/false);
-      } else {
-        state.timer -= 1;
-        ++itr;
-      }
+    // Count down every timer at once and then recover the expired
+    // starting from the back so that erasing, which swaps in the
+    // last agent, never moves an index still to be erased.
+    abmoid::count_down(I.get_values(), expired);
+    for (std::uint32_t index : expired | std::views::reverse) {
+      person p = I.get_agent(index);
+      R.create(p);
+      I.erase(I.begin() + index);
+      connections.update(p, /*is_infected=*/false);
     }
   }
 
@@ -260,19 +666,114 @@ class agent_model {
     // Do nothing.
   }
 
+  void update_S_block(std::size_t block, std::mt19937& block_gen,
+                      block_transitions& out, std::vector<int>& I_delta) {
+    std::size_t first = block * block_size;
+    std::size_t count = std::min(block_size, S.size() - first);
+
+    std::vector<bool> is_infected(count, false);
+    for (auto [g, p_g] : std::views::zip(social_groups, contact_probs)) {
+      abmoid::bernoulli_skip skip(p_g);
+      for (std::size_t i = skip.next(block_gen, 0); i < count;
+           i = skip.next(block_gen, i + 1)) {
+        if (is_infected[i])
+          continue;
+        person p = S.get_agent(first + i);
+        if (connections.contains(g, p))
+          is_infected[i] = is_infected_by_contact(g, block_gen);
+      }
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+      if (is_infected[i])
+        add_infected(S.get_agent(first + i), block_gen, out, I_delta);
+  }
+
+  // Test each susceptible of the block once against the combined
+  // probability of its cohort's groups.
+  void update_S_block_dense(std::size_t block, std::mt19937& block_gen,
+                            block_transitions& out,
+                            std::vector<int>& I_delta) {
+    std::size_t first = block * block_size;
+    std::size_t count = std::min(block_size, S.size() - first);
+
+    std::uint64_t seed = block_gen();
+    abmoid::lane_rng<16> rng(seed << 32 | block_gen());
+    std::span<susceptible_state const> values =
+      S.get_values().subspan(first, count);
+    abmoid::contact_test(values, &susceptible_state::timer,
+                         &susceptible_state::cohort,
+                         cohort_thresholds, rng, out.indices);
+    for (std::uint32_t i : out.indices)
+      add_infected(S.get_agent(first + i), block_gen, out, I_delta);
+  }
+
+  void add_infected(person p, std::mt19937& block_gen,
+                    block_transitions& out, std::vector<int>& I_delta) {
+    unsigned timer = gen_I_timer(block_gen);
+    out.infected.push_back({p, timer});
+    // A zero timer recovers within the frame.
+    if (timer > 0)
+      connections.for_each_group(p, [&](unsigned index, social_group) {
+        ++I_delta[index];
+      });
+  }
+
+  void update_I_block(std::size_t block, block_transitions& out,
+                      std::vector<int>& I_delta) {
+    std::size_t first = block * block_size;
+    std::size_t count = std::min(block_size, I.size() - first);
+
+    abmoid::count_down(I.get_values().subspan(first, count), out.indices);
+    for (std::uint32_t i : out.indices) {
+      person p = I.get_agent(first + i);
+      out.recovered.push_back(p);
+      connections.for_each_group(p, [&](unsigned index, social_group) {
+        --I_delta[index];
+      });
+    }
+  }
+
 public:
   using seed_type = std::mt19937::result_type;
 
   agent_model(parameters const& params,
         seed_type seed = std::mt19937::default_seed)
     : gamma(params.gamma),
-      gen(seed),
       people(0),
-      social_groups(params.groups.size())
+      social_groups(params.groups.size()),
+      gen(seed)
   {
     init(params);
   }
 
+  // Restore a model saved with save. The parameters must be the ones
+  // the saved model was constructed with.
+  agent_model(parameters const& params, mapped_snapshot const& snapshot)
+    : gamma(params.gamma),
+      people(0),
+      social_groups(params.groups.size()),
+      gen()
+  {
+    init_groups(params);
+    load(snapshot);
+  }
+
+  // Construct the same model using the threads of the pool.
+  agent_model(parameters const& params, seed_type seed,
+              abmoid::thread_pool& pool)
+    : gamma(params.gamma),
+      people(0),
+      social_groups(params.groups.size()),
+      gen(seed)
+  {
+    init(params, pool);
+  }
+
+  void set_direction_policy(direction_policy policy) {
+    choose_direction = policy;
+  }
+
   // Each frame we call update.
   void update() {
     update_S();
@@ -280,6 +781,247 @@ public:
     update_R();
   }
 
+  // Update a frame using the threads of the pool.
+  //
+  // Unlike update(), every agent sees each group's I/N as it was at
+  // the start of the frame so that S and I can be split into blocks
+  // that update independently. Each block draws from its own
+  // generator seeded from the model's generator and buffers its
+  // transitions, which are applied in block order at the end of the
+  // frame. The group counts are reduced from per-thread deltas.
+  // Results depend on the seed but not on the number of threads.
+  void update(abmoid::thread_pool& pool) {
+    auto num_blocks = [](std::size_t n) {
+      return (n + block_size - 1) / block_size;
+    };
+    std::size_t S_blocks = num_blocks(S.size());
+    std::size_t I_blocks = num_blocks(I.size());
+
+    contact_probs.clear();
+    for (auto const& [I_g, N_g, beta_star_g] : connections.get_group_states())
+      contact_probs.push_back(static_cast<double>(I_g) /
+                              static_cast<double>(N_g));
+
+    // Once contacts are common, skipping to them saves little over
+    // testing everyone and each contact costs a membership lookup.
+    // The probability that a cohort member escapes infection is the
+    // product over its groups of escaping contact or, given contact,
+    // drawing an exponential timer that rounds to more than zero.
+    double contact_rate = 0.0;
+    for (double p_g : contact_probs)
+      contact_rate += p_g;
+    bool is_dense = contact_rate > dense_contact_rate;
+    if (is_dense) {
+      auto const& states = connections.get_group_states();
+      cohort_thresholds.clear();
+      for (std::vector<unsigned> const& group_indices : cohort_groups) {
+        double escape = 1.0;
+        for (unsigned index : group_indices) {
+          double beta_star_g = states.get_values()[index].beta_star;
+          escape *= 1.0 - contact_probs[index] *
+                          -std::expm1(-0.5 * beta_star_g);
+        }
+        cohort_thresholds.push_back(abmoid::to_threshold(1.0 - escape));
+      }
+    }
+
+    blocks.resize(S_blocks + I_blocks);
+    for (block_transitions& b : blocks) {
+      b.seed = gen();
+      b.infected.clear();
+      b.recovered.clear();
+    }
+
+    I_deltas.resize(pool.size());
+    for (std::vector<int>& I_delta : I_deltas)
+      I_delta.assign(contact_probs.size(), 0);
+
+    pool.parallel_for(blocks.size(), [&](std::size_t block,
+                                         unsigned thread_index) {
+      std::mt19937 block_gen(blocks[block].seed);
+      std::vector<int>& I_delta = I_deltas[thread_index];
+      if (block < S_blocks && is_dense)
+        update_S_block_dense(block, block_gen, blocks[block], I_delta);
+      else if (block < S_blocks)
+        update_S_block(block, block_gen, blocks[block], I_delta);
+      else
+        update_I_block(block - S_blocks, blocks[block], I_delta);
+    });
+
+    // As in update(), the newly infected count down with the rest.
+    for (block_transitions const& b : blocks) {
+      for (auto [p, timer] : b.infected) {
+        auto itr = S.find(p);
+        for (unsigned index : cohort_groups[itr->cohort])
+          connections.add_S_count(index, -1);
+        S.erase(itr);
+        if (timer == 0)
+          R.create(p);
+        else
+          I.create(p, infected_state{timer - 1});
+      }
+    }
+    for (block_transitions const& b : blocks) {
+      for (person p : b.recovered) {
+        I.erase(I.find(p));
+        R.create(p);
+      }
+    }
+
+    for (std::vector<int> const& I_delta : I_deltas)
+      for (unsigned index = 0; index < I_delta.size(); ++index)
+        connections.add_I_count(index, I_delta[index]);
+  }
+
+  // Write the state of the model between frames so it can be
+  // restored to continue as if it had never stopped.
+  //
+  // Each component's agents and values, the group states and members,
+  // the people of each cohort and the generator are sections that
+  // are read in place from the mapped snapshot and copied back. Only
+  // the lookups, which are hashed, are built again. The direction
+  // policy is not saved.
+  void save(std::ostream& out) const {
+    auto const& states = connections.get_group_states();
+    std::vector<std::uint64_t> member_counts;
+    std::vector<person> members;
+    for (unsigned index = 0; index < states.size(); ++index) {
+      auto const& group_members =
+        connections.get_members(states.get_agent(index));
+      member_counts.push_back(group_members.size());
+      members.insert(members.end(), group_members.begin(),
+                     group_members.end());
+    }
+    std::vector<std::uint64_t> cohort_counts;
+    std::vector<person> cohort_members;
+    for (std::vector<person> const& cohort : cohort_people) {
+      cohort_counts.push_back(cohort.size());
+      cohort_members.insert(cohort_members.end(), cohort.begin(),
+                            cohort.end());
+    }
+    // The standard only exposes the state of the generator as text.
+    std::ostringstream gen_state;
+    gen_state << gen;
+    std::string gen_text = gen_state.str();
+
+    snapshot_info info{
+      .version = snapshot_info::current_version,
+      .group_count = static_cast<std::uint32_t>(states.size()),
+      .cohort_count = cohort_people.size(),
+      .population_size = people.size()
+    };
+    snapshot_writer writer;
+    writer.add_value(info);
+    writer.add(states.get_values());
+    writer.add(std::span<std::uint64_t const>(member_counts));
+    writer.add(std::span<person const>(members));
+    writer.add(std::span<std::uint64_t const>(cohort_counts));
+    writer.add(std::span<person const>(cohort_members));
+    writer.add(S.get_agents());
+    writer.add(S.get_values());
+    writer.add(I.get_agents());
+    writer.add(I.get_values());
+    writer.add(R.get_agents());
+    writer.add(std::span<char const>(gen_text));
+    writer.write(out);
+  }
+
+  // Replace the state of the model with one saved with save from a
+  // model of the same parameters.
+  void load(mapped_snapshot const& snapshot) {
+    std::size_t section = 0;
+    auto const& info = snapshot.get_value<snapshot_info>(section++);
+    if (info.version != snapshot_info::current_version)
+      throw std::runtime_error("snapshot: unsupported model version");
+    if (info.group_count != connections.get_group_states().size() ||
+        info.cohort_count != cohort_people.size())
+      throw std::runtime_error("snapshot: does not match the parameters");
+
+    auto states = snapshot.get<group_state>(section++);
+    auto member_counts = snapshot.get<std::uint64_t>(section++);
+    auto members = snapshot.get<person>(section++);
+    auto cohort_counts = snapshot.get<std::uint64_t>(section++);
+    auto cohort_members = snapshot.get<person>(section++);
+    auto S_agents = snapshot.get<person>(section++);
+    auto S_values = snapshot.get<susceptible_state>(section++);
+    auto I_agents = snapshot.get<person>(section++);
+    auto I_values = snapshot.get<infected_state>(section++);
+    auto R_agents = snapshot.get<person>(section++);
+    auto gen_text = snapshot.get<char>(section++);
+    if (states.size() != info.group_count ||
+        member_counts.size() != info.group_count ||
+        cohort_counts.size() != info.cohort_count ||
+        S_agents.size() != S_values.size() ||
+        I_agents.size() != I_values.size() ||
+        std::accumulate(member_counts.begin(), member_counts.end(),
+                        std::uint64_t(0)) != members.size() ||
+        std::accumulate(cohort_counts.begin(), cohort_counts.end(),
+                        std::uint64_t(0)) != cohort_members.size())
+      throw std::runtime_error("snapshot: inconsistent sections");
+
+    // Every person must be one of the population, which is never
+    // smaller than S, I and R together, any group or every cohort.
+    std::uint64_t N = info.population_size;
+    auto are_people = [&](std::span<person const> agents) {
+      return std::ranges::all_of(agents, [&](person p) {
+        return p.is_valid() && p.get_id() <= N;
+      });
+    };
+    auto is_in_cohort = [&](susceptible_state const& state) {
+      return state.cohort < info.cohort_count;
+    };
+    if (N > std::numeric_limits<person::id_type>::max() ||
+        S_agents.size() + I_agents.size() + R_agents.size() > N ||
+        std::ranges::any_of(member_counts,
+                            [&](std::uint64_t count) { return count > N; }) ||
+        cohort_members.size() > N ||
+        !are_people(S_agents) || !are_people(I_agents) ||
+        !are_people(R_agents) || !are_people(members) ||
+        !are_people(cohort_members) ||
+        !std::ranges::all_of(S_values, is_in_cohort))
+      throw std::runtime_error("snapshot: inconsistent people");
+
+    people = abmoid::population_t<person>(info.population_size);
+
+    // The susceptible members of each group are counted from the
+    // cohorts of S rather than saved.
+    std::vector<unsigned> S_counts(info.group_count, 0);
+    for (susceptible_state const& state : S_values)
+      for (unsigned index : cohort_groups[state.cohort])
+        ++S_counts[index];
+
+    connections.clear_members();
+    connections.reserve(members.size());
+    std::size_t first = 0;
+    for (unsigned index = 0; index < info.group_count; ++index) {
+      connections.add_members(index,
+                              members.subspan(first, member_counts[index]),
+                              S_counts[index], 0);
+      connections.set_counts(index, states[index].I_count,
+                             states[index].N_count);
+      first += member_counts[index];
+    }
+
+    first = 0;
+    for (std::size_t cohort = 0; cohort < info.cohort_count; ++cohort) {
+      auto cohort_span = cohort_members.subspan(first, cohort_counts[cohort]);
+      cohort_people[cohort].assign(cohort_span.begin(), cohort_span.end());
+      first += cohort_counts[cohort];
+    }
+
+    S.clear();
+    I.clear();
+    R.clear();
+    S.append(S_agents, S_values);
+    I.append(I_agents, I_values);
+    R.append(R_agents);
+
+    std::istringstream gen_state(std::string(gen_text.begin(),
+                                             gen_text.end()));
+    if (!(gen_state >> gen))
+      throw std::runtime_error("snapshot: invalid generator state");
+  }
+
   auto get_state() const {
     return std::array<size_t, 3>{{S.size(), I.size(), R.size()}};
   }
@@ -293,6 +1035,60 @@ public:
   auto const& get_group_states() const {
     return connections.get_group_states();
   }
+
+  // Overwrite the counts of the group at index in get_group_states()
+  // such as with counts kept by another model sharing the group.
+  void set_group_counts(unsigned index, unsigned I_count, unsigned N_count) {
+    connections.set_counts(index, I_count, N_count);
+  }
+
+  // Add people to a cohort, the index of its connection_spec,
+  // with new timers for the infected.
+  void add_cohort(unsigned cohort, unsigned S_count, unsigned I_count) {
+    std::vector<unsigned> const& group_indices = cohort_groups[cohort];
+    auto const& states = connections.get_group_states();
+    auto add = [&](bool is_infected) {
+      person p = people.push_back();
+      if (is_infected)
+        I.create(p, infected_state{gen_I_timer(gen)});
+      else
+        S.create(p, susceptible_state{0, cohort});
+      for (unsigned index : group_indices)
+        connections.add(p, states.get_agent(index), is_infected);
+      cohort_people[cohort].push_back(p);
+    };
+    for (unsigned i = 0; i < S_count; ++i)
+      add(/*is_infected=*/false);
+    for (unsigned i = 0; i < I_count; ++i)
+      add(/*is_infected=*/true);
+  }
+
+  // Remove every person of a cohort and return how many
+  // were susceptible, infected and recovered.
+  std::array<unsigned, 3> remove_cohort(unsigned cohort) {
+    std::vector<person>& members = cohort_people[cohort];
+    std::unordered_set<person> removed(members.begin(), members.end());
+    for (unsigned index : cohort_groups[cohort])
+      connections.remove(index, removed,
+                         [&](person p) { return S.contains(p); },
+                         [&](person p) { return I.contains(p); });
+
+    std::array<unsigned, 3> counts{};
+    for (person p : members) {
+      if (auto itr = S.find(p); itr != S.end()) {
+        S.erase(itr);
+        ++counts[0];
+      } else if (auto itr = I.find(p); itr != I.end()) {
+        I.erase(itr);
+        ++counts[1];
+      } else {
+        R.erase(R.find(p));
+        ++counts[2];
+      }
+    }
+    members.clear();
+    return counts;
+  }
 };
 }
 
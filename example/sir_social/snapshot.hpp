@@ -0,0 +1,162 @@
+#ifndef SIR_SOCIAL_SNAPSHOT_HPP
+#define SIR_SOCIAL_SNAPSHOT_HPP
+
+#include <abmoid/mapped_file.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace sir_social {
+
+// A snapshot is this header, a table of sections and then the
+// records of each section, all in the byte order of the machine that
+// wrote it. Each section starts on an 8 byte boundary so a mapped
+// snapshot can be read in place.
+struct snapshot_header {
+  static constexpr char expected_magic[8] = {'A', 'B', 'M', 'O',
+                                             'I', 'D', 'S', 'N'};
+  static constexpr std::uint32_t current_version = 1;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t section_count;
+};
+
+struct snapshot_section {
+  // The size of the records so a snapshot from a different layout
+  // is rejected.
+  std::uint64_t record_size;
+  std::uint64_t count;
+  // From the start of the snapshot.
+  std::uint64_t offset;
+};
+
+static_assert(sizeof(snapshot_header) % 8 == 0 &&
+              sizeof(snapshot_section) % 8 == 0);
+
+// Collect sections of trivially copyable records and write them as
+// a snapshot. The records are not copied until write.
+class snapshot_writer {
+  std::vector<snapshot_section> sections;
+  std::vector<std::span<std::byte const>> data;
+
+  static std::uint64_t align(std::uint64_t offset) {
+    return (offset + 7) & ~std::uint64_t(7);
+  }
+
+public:
+  template <typename T>
+  void add(std::span<T const> records) {
+    static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= 8);
+    sections.push_back(snapshot_section{
+      .record_size = sizeof(T),
+      .count = records.size(),
+      .offset = 0
+    });
+    data.push_back(std::as_bytes(records));
+  }
+
+  template <typename T>
+  void add_value(T const& value) {
+    add(std::span<T const>(&value, 1));
+  }
+
+  void write(std::ostream& out) {
+    snapshot_header header{};
+    std::ranges::copy(snapshot_header::expected_magic, header.magic);
+    header.version = snapshot_header::current_version;
+    header.section_count = sections.size();
+
+    std::uint64_t offset = sizeof(header) +
+                           sections.size() * sizeof(snapshot_section);
+    for (auto [section, bytes] : std::views::zip(sections, data)) {
+      offset = align(offset);
+      section.offset = offset;
+      offset += bytes.size();
+    }
+
+    out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    out.write(reinterpret_cast<char const*>(sections.data()),
+              sections.size() * sizeof(snapshot_section));
+    offset = sizeof(header) + sections.size() * sizeof(snapshot_section);
+    constexpr char padding[8] = {};
+    for (auto [section, bytes] : std::views::zip(sections, data)) {
+      out.write(padding, section.offset - offset);
+      out.write(reinterpret_cast<char const*>(bytes.data()), bytes.size());
+      offset = section.offset + bytes.size();
+    }
+    if (!out)
+      throw std::runtime_error("snapshot: write failed");
+  }
+};
+
+// A snapshot written by snapshot_writer mapped read only.
+class mapped_snapshot {
+  abmoid::mapped_file file;
+  std::span<snapshot_section const> sections;
+
+public:
+  explicit mapped_snapshot(std::string const& path)
+    : file(path, "snapshot", sizeof(snapshot_header))
+  {
+    std::span<std::byte const> bytes = file.get_bytes();
+    snapshot_header header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    std::size_t table_end = sizeof(header) +
+      std::size_t(header.section_count) * sizeof(snapshot_section);
+    if (!std::ranges::equal(header.magic, snapshot_header::expected_magic))
+      file.fail("not a snapshot");
+    if (header.version != snapshot_header::current_version)
+      file.fail("unsupported version");
+    if (bytes.size() < table_end)
+      file.fail("truncated");
+
+    sections = {reinterpret_cast<snapshot_section const*>(
+                  bytes.data() + sizeof(header)), header.section_count};
+    for (snapshot_section const& section : sections) {
+      if (section.offset % 8 != 0 || section.offset > bytes.size() ||
+          section.count > (bytes.size() - section.offset) /
+                          std::max<std::uint64_t>(section.record_size, 1))
+        file.fail("truncated");
+    }
+  }
+
+  std::size_t get_section_count() const {
+    return sections.size();
+  }
+
+  // The records of the section at index in the order they were
+  // added.
+  template <typename T>
+  std::span<T const> get(std::size_t index) const {
+    static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= 8);
+    if (index >= sections.size())
+      throw std::runtime_error("snapshot: missing section");
+    snapshot_section const& section = sections[index];
+    if (section.record_size != sizeof(T))
+      throw std::runtime_error("snapshot: unsupported record layout");
+    auto bytes = file.get_bytes().data() + section.offset;
+    return {reinterpret_cast<T const*>(bytes), section.count};
+  }
+
+  template <typename T>
+  T const& get_value(std::size_t index) const {
+    std::span<T const> records = get<T>(index);
+    if (records.size() != 1)
+      throw std::runtime_error("snapshot: unsupported record layout");
+    return records[0];
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef ABMOID_AFFINITY_HPP
+#define ABMOID_AFFINITY_HPP
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace abmoid {
+
+// Return the CPUs of each NUMA node as listed in sysfs.
+// Without NUMA information every CPU is on a single node.
+inline std::vector<std::vector<int>> get_numa_nodes() {
+  std::vector<std::vector<int>> nodes;
+  for (unsigned node = 0;; ++node) {
+    std::ifstream file("/sys/devices/system/node/node" +
+                       std::to_string(node) + "/cpulist");
+    if (!file)
+      break;
+
+    // The list looks like "0-3,8-11".
+    std::vector<int> cpus;
+    std::string range;
+    while (std::getline(file, range, ',')) {
+      std::istringstream in(range);
+      int first = 0;
+      int last = 0;
+      char dash = 0;
+      if (!(in >> first))
+        continue;
+      if (!(in >> dash >> last))
+        last = first;
+      for (int cpu = first; cpu <= last; ++cpu)
+        cpus.push_back(cpu);
+    }
+    if (!cpus.empty())
+      nodes.push_back(std::move(cpus));
+  }
+
+  if (nodes.empty()) {
+    nodes.emplace_back();
+    unsigned num_cpus = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned cpu = 0; cpu < num_cpus; ++cpu)
+      nodes.back().push_back(cpu);
+  }
+  return nodes;
+}
+
+// Where the threads of a pool run.
+//
+// Threads that stay on one CPU keep the memory they first touch
+// on their own NUMA node, so data owned by a thread should be
+// allocated and initialized by that thread.
+struct affinity_policy {
+  enum mode_t {
+    // Leave placement to the OS.
+    none,
+    // Fill the CPUs of one node before moving to the next.
+    compact,
+    // Take turns between nodes to use every memory controller.
+    scatter,
+    // Use `cpus` in order.
+    explicit_cpus
+  };
+
+  mode_t mode = none;
+  std::vector<int> cpus = {};
+
+  // Return the CPU for a thread, or -1 to leave it unpinned.
+  int get_cpu(unsigned thread_index) const {
+    if (mode == none)
+      return -1;
+    if (mode == explicit_cpus) {
+      if (cpus.empty())
+        return -1;
+      return cpus[thread_index % cpus.size()];
+    }
+
+    std::vector<std::vector<int>> nodes = get_numa_nodes();
+    std::vector<int> order;
+    if (mode == compact) {
+      for (std::vector<int> const& node : nodes)
+        order.insert(order.end(), node.begin(), node.end());
+    } else {
+      for (std::size_t i = 0;; ++i) {
+        std::size_t added = 0;
+        for (std::vector<int> const& node : nodes) {
+          if (i < node.size()) {
+            order.push_back(node[i]);
+            ++added;
+          }
+        }
+        if (added == 0)
+          break;
+      }
+    }
+    return order[thread_index % order.size()];
+  }
+};
+
+// Pin the calling thread to a CPU.
+// Return false if the thread was not pinned.
+inline bool pin_current_thread(int cpu) {
+#ifdef __linux__
+  if (cpu < 0 || cpu >= CPU_SETSIZE)
+    return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
+
+// The CPUs a thread may run on, saved so they can be restored after
+// pinning it.
+class thread_affinity {
+#ifdef __linux__
+  cpu_set_t set;
+#endif
+  bool is_saved = false;
+
+public:
+  thread_affinity() = default;
+
+  // Save the affinity of the calling thread.
+  static thread_affinity get_current() {
+    thread_affinity affinity;
+#ifdef __linux__
+    CPU_ZERO(&affinity.set);
+    affinity.is_saved =
+      sched_getaffinity(0, sizeof(affinity.set), &affinity.set) == 0;
+#endif
+    return affinity;
+  }
+
+  // Restore the saved affinity to the calling thread.
+  // Return false if nothing was restored.
+  bool restore() const {
+#ifdef __linux__
+    return is_saved && sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+  }
+};
+
+}  // namespace abmoid
+
+#endif
@@ -145,6 +145,14 @@ public:
     return Agent{++N};
   }
 
+  // Add count agents at once and return the first of them.
+  // The rest follow it in order.
+  iterator append(id_type count) {
+    iterator first{N + 1};
+    N += count;
+    return first;
+  }
+
   id_type size() const {
     return N;
   }
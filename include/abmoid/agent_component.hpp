@@ -2,6 +2,7 @@
 #define ABMOID_AGENT_COMPONENT_HPP
 
 #include <cassert>
+#include <span>
 #include <type_traits>
 #include <unordered_map>
 #include <vector>
@@ -56,7 +57,9 @@ public:
     using std::swap;
     swap(*itr, values.back());
     swap(*agent_itr, agents.back());
-    lookup[*agent_itr] = index;
+    // The last element has nothing swapped in to reindex.
+    if (index + 1 < agents.size())
+      lookup[*agent_itr] = index;
     values.pop_back();
     agents.pop_back();
 
@@ -88,6 +91,22 @@ public:
     return values.back();
   }
 
+  // Create the components of many agents at once, such as ones
+  // filled in parallel, with the lookup reserved up front.
+  void append(std::span<Agent const> new_agents,
+              std::span<Value const> new_values) {
+    assert(new_agents.size() == new_values.size());
+    index_t first = values.size();
+    values.insert(values.end(), new_values.begin(), new_values.end());
+    agents.insert(agents.end(), new_agents.begin(), new_agents.end());
+    lookup.reserve(agents.size());
+    for (index_t index = first; index < agents.size(); ++index) {
+      [[maybe_unused]] auto [itr, did_insert] =
+        lookup.try_emplace(agents[index], index);
+      assert(did_insert && "only one component per entity is allowed");
+    }
+  }
+
   Agent get_agent(index_t index) const {
     assert(index < agents.size());
     return agents[index];
@@ -96,6 +115,12 @@ public:
   Agent get_agent(iterator itr) {
     return get_agent(std::distance(values.begin(), itr));
   }
+
+  // Contiguous values for batch kernels.
+  // The agent at each index is get_agent(index).
+  std::span<Value> get_values() { return values; }
+  std::span<Value const> get_values() const { return values; }
+  std::span<Agent const> get_agents() const { return agents; }
 };
 
 template <typename T>
@@ -126,7 +151,6 @@ public:
   iterator end() { return agents.end(); }
   iterator erase(iterator itr) {
     index_t index = std::distance(std::cbegin(agents), itr);
-    auto agent_itr = agents.begin() + index;
     auto lookup_itr = lookup.find(*itr);
     assert(agents.size() > index &&
         "corresponding agent entry should exist");
@@ -145,7 +169,9 @@ public:
     // remove the element without reindexing everything.
     using std::swap;
     swap(const_cast<Agent&>(*itr), agents.back());
-    lookup[*itr] = index;
+    // The last element has nothing swapped in to reindex.
+    if (index + 1 < agents.size())
+      lookup[*itr] = index;
     agents.pop_back();
 
     // Since itr was swapped with the back, we do not increment.
@@ -156,13 +182,33 @@ public:
     return lookup.contains(a);
   }
 
-  Value create(Agent a, Value v = {}) {
+  iterator find(Agent a) const {
+    auto lookup_itr = lookup.find(a);
+    if (lookup_itr == lookup.end())
+      return agents.end();
+
+    assert(agents.size() > lookup_itr->second);
+    return agents.begin() + lookup_itr->second;
+  }
+
+  Value create(Agent a, Value = {}) {
     assert(!contains(a) && "only one component per entity is allowed");
     lookup[a] = agents.size();
     agents.push_back(a);
     return Value{};
   }
 
+  void append(std::span<Agent const> new_agents) {
+    index_t first = agents.size();
+    agents.insert(agents.end(), new_agents.begin(), new_agents.end());
+    lookup.reserve(agents.size());
+    for (index_t index = first; index < agents.size(); ++index) {
+      [[maybe_unused]] auto [itr, did_insert] =
+        lookup.try_emplace(agents[index], index);
+      assert(did_insert && "only one component per entity is allowed");
+    }
+  }
+
   Agent get_agent(index_t index) const {
     assert(index < agents.size());
     return agents[index];
@@ -171,6 +217,8 @@ public:
   Agent get_agent(iterator itr) const {
     return *itr;
   }
+
+  std::span<Agent const> get_agents() const { return agents; }
 };
 
 }
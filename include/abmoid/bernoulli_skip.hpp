@@ -0,0 +1,89 @@
+#ifndef ABMOID_BERNOULLI_SKIP_HPP
+#define ABMOID_BERNOULLI_SKIP_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <ranges>
+
+namespace abmoid {
+
+// Sample the number of failed trials before the next success
+// in a run of independent Bernoulli trials with probability p.
+// This is the geometric distribution, but unlike
+// std::geometric_distribution it accepts p = 0 (never succeeds)
+// and p = 1 (always succeeds) so callers need not special case
+// empty or saturated groups.
+class bernoulli_skip {
+  double p;
+  // 1 / log(1 - p)
+  double inv_log_q;
+
+public:
+  using result_type = std::size_t;
+
+  // Returned when there will never be a success.
+  static constexpr result_type never =
+    std::numeric_limits<result_type>::max();
+
+  explicit bernoulli_skip(double p = 0.0)
+    : p(p),
+      inv_log_q(1.0 / std::log1p(-p))
+  { }
+
+  double probability() const {
+    return p;
+  }
+
+  template <typename Gen>
+  result_type operator()(Gen& gen) const {
+    // Also catches NaN from 0 / 0.
+    if (!(p > 0.0))
+      return never;
+    if (p >= 1.0)
+      return 0;
+
+    // Inverse transform sampling where
+    // P(skip >= k) = P(1 - u <= (1 - p)^k) = (1 - p)^k.
+    double u = std::uniform_real_distribution<double>()(gen);
+    double skip = std::floor(std::log1p(-u) * inv_log_q);
+    if (skip >= static_cast<double>(never))
+      return never;
+    return static_cast<result_type>(skip);
+  }
+
+  // Return the index of the next success counting trials from `first`.
+  template <typename Gen>
+  result_type next(Gen& gen, result_type first) const {
+    result_type skip = (*this)(gen);
+    if (skip >= never - first)
+      return never;
+    return first + skip;
+  }
+};
+
+// Call fn(itr) for each element of the range that succeeds a
+// Bernoulli trial with probability p, drawing one random number per
+// success rather than one per element.
+// The range must not be resized by fn.
+template <std::ranges::random_access_range Range, typename Gen, typename Fn>
+void for_each_bernoulli(Range&& range, double p, Gen& gen, Fn&& fn) {
+  bernoulli_skip skip(p);
+  auto itr = std::ranges::begin(range);
+  auto end = std::ranges::end(range);
+  while (true) {
+    auto remaining = static_cast<std::size_t>(std::ranges::distance(itr, end));
+    bernoulli_skip::result_type n = skip(gen);
+    if (n >= remaining)
+      return;
+    itr += n;
+    fn(itr);
+    ++itr;
+  }
+}
+
+}  // namespace abmoid
+
+#endif
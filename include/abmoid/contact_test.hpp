@@ -0,0 +1,159 @@
+#ifndef ABMOID_CONTACT_TEST_HPP
+#define ABMOID_CONTACT_TEST_HPP
+
+#include <abmoid/count_down.hpp>
+#include <abmoid/lane_rng.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace abmoid {
+
+// Threshold for which a uniform 32 bit integer is below with
+// probability p.
+inline std::uint32_t to_threshold(double p) {
+  constexpr double scale = 4294967296.0;
+  if (!(p > 0.0))
+    return 0;
+  if (p >= 1.0)
+    return UINT32_MAX;
+  return static_cast<std::uint32_t>(
+    std::min(p * scale, static_cast<double>(UINT32_MAX)));
+}
+
+namespace detail {
+// The timer and group of agent i are the 32 bit values at
+// timers + i * stride and groups + i * stride.
+inline void contact_test(char const* timers, char const* groups,
+                         std::size_t stride, std::size_t size,
+                         std::span<std::uint32_t const> thresholds,
+                         lane_rng<16>& rng,
+                         std::vector<std::uint32_t>& contacts) {
+  // Vector stores may write a full vector past the last index.
+  contacts.resize(size + 16);
+  std::uint32_t* out = contacts.data();
+  std::size_t count = 0;
+  std::size_t i = 0;
+  lane_rng<16>::batch r;
+
+#if defined(__AVX512F__)
+  __m512i const lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                          8, 9, 10, 11, 12, 13, 14, 15);
+  __m512i const offsets = _mm512_mullo_epi32(
+    lanes, _mm512_set1_epi32(static_cast<int>(stride)));
+  for (; i + 16 <= size; i += 16) {
+    rng.next(r);
+    __m512i t = _mm512_i32gather_epi32(offsets, timers + i * stride, 1);
+    __m512i g = _mm512_i32gather_epi32(offsets, groups + i * stride, 1);
+    __m512i th = _mm512_i32gather_epi32(g, thresholds.data(), 4);
+    __m512i u = _mm512_loadu_si512(r.data());
+    __mmask16 is_zero = _mm512_cmpeq_epi32_mask(t, _mm512_setzero_si512());
+    __mmask16 hit = _mm512_mask_cmplt_epu32_mask(is_zero, u, th);
+
+    __m512i index = _mm512_add_epi32(lanes, _mm512_set1_epi32(i));
+    _mm512_mask_compressstoreu_epi32(out + count, hit, index);
+    count += std::popcount(static_cast<unsigned>(hit));
+  }
+#elif defined(__AVX2__)
+  __m256i const offsets = _mm256_mullo_epi32(
+    _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+    _mm256_set1_epi32(static_cast<int>(stride)));
+  __m256i const zero = _mm256_setzero_si256();
+  // Flip the sign bits to compare unsigned values as signed.
+  __m256i const sign = _mm256_set1_epi32(INT32_MIN);
+  auto const* table = reinterpret_cast<int const*>(thresholds.data());
+  for (; i + 16 <= size; i += 16) {
+    rng.next(r);
+    for (std::size_t half = 0; half < 16; half += 8) {
+      std::size_t first = i + half;
+      __m256i t = _mm256_i32gather_epi32(
+        reinterpret_cast<int const*>(timers + first * stride), offsets, 1);
+      __m256i g = _mm256_i32gather_epi32(
+        reinterpret_cast<int const*>(groups + first * stride), offsets, 1);
+      __m256i th = _mm256_i32gather_epi32(table, g, 4);
+      __m256i u = _mm256_loadu_si256(
+        reinterpret_cast<__m256i const*>(r.data() + half));
+      __m256i is_below = _mm256_cmpgt_epi32(_mm256_xor_si256(th, sign),
+                                            _mm256_xor_si256(u, sign));
+      __m256i hit = _mm256_and_si256(_mm256_cmpeq_epi32(t, zero), is_below);
+
+      unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(hit));
+      auto const& lanes = compress_lanes[mask];
+      __m256i perm = _mm256_loadu_si256(
+        reinterpret_cast<__m256i const*>(lanes.data()));
+      __m256i index = _mm256_add_epi32(perm, _mm256_set1_epi32(first));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + count), index);
+      count += std::popcount(mask);
+    }
+  }
+#endif
+
+  // Each batch of 16 agents uses one batch of uniforms on every path
+  // so the contacts do not depend on the instruction set.
+  for (; i < size; i += 16) {
+    rng.next(r);
+    std::size_t n = std::min<std::size_t>(16, size - i);
+    for (std::size_t k = 0; k < n; ++k) {
+      std::uint32_t t;
+      std::uint32_t g;
+      std::memcpy(&t, timers + (i + k) * stride, sizeof(t));
+      std::memcpy(&g, groups + (i + k) * stride, sizeof(g));
+      assert(g < thresholds.size());
+      out[count] = static_cast<std::uint32_t>(i + k);
+      count += (t == 0) & (r[k] < thresholds[g]);
+    }
+  }
+
+  contacts.resize(count);
+}
+}
+
+// Test every agent whose timer is zero for contact with probability
+// thresholds[group] / 2^32 and write the indices of the agents that
+// made contact to `contacts` in ascending order.
+//
+// The uniforms for 16 agents are drawn at once, one per lane, and
+// each agent's threshold is gathered from the table by its group.
+// Agents with a nonzero timer still use up their uniform.
+template <typename Value>
+void contact_test(std::span<Value const> values,
+                  unsigned Value::* timer, unsigned Value::* group,
+                  std::span<std::uint32_t const> thresholds,
+                  lane_rng<16>& rng, std::vector<std::uint32_t>& contacts) {
+  static_assert(sizeof(unsigned) == sizeof(std::uint32_t));
+  if (values.empty()) {
+    contacts.clear();
+    return;
+  }
+  auto const* timers = reinterpret_cast<char const*>(&(values[0].*timer));
+  auto const* groups = reinterpret_cast<char const*>(&(values[0].*group));
+  detail::contact_test(timers, groups, sizeof(Value), values.size(),
+                       thresholds, rng, contacts);
+}
+
+// As above with timers and groups in separate arrays.
+inline void contact_test(std::span<std::uint32_t const> timers,
+                         std::span<std::uint32_t const> groups,
+                         std::span<std::uint32_t const> thresholds,
+                         lane_rng<16>& rng,
+                         std::vector<std::uint32_t>& contacts) {
+  assert(timers.size() == groups.size());
+  detail::contact_test(reinterpret_cast<char const*>(timers.data()),
+                       reinterpret_cast<char const*>(groups.data()),
+                       sizeof(std::uint32_t), timers.size(),
+                       thresholds, rng, contacts);
+}
+
+}  // namespace abmoid
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef ABMOID_COUNT_DOWN_HPP
+#define ABMOID_COUNT_DOWN_HPP
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace abmoid {
+
+// A timer is any trivially copyable value that is
+// a single 32 bit unsigned count such as `struct { unsigned timer; }`.
+template <typename T>
+concept Timer = std::is_trivially_copyable_v<T> &&
+                sizeof(T) == sizeof(std::uint32_t);
+
+namespace detail {
+#if defined(__AVX2__) && !defined(__AVX512F__)
+// For each 8 bit mask, the lanes of the set bits packed to the front.
+constexpr auto compress_lanes = [] {
+  std::array<std::array<std::uint32_t, 8>, 256> table{};
+  for (unsigned mask = 0; mask < 256; ++mask) {
+    unsigned n = 0;
+    for (unsigned lane = 0; lane < 8; ++lane)
+      if (mask & (1u << lane))
+        table[mask][n++] = lane;
+  }
+  return table;
+}();
+#endif
+}
+
+// Count down every timer that is not yet zero and write the indices
+// of the timers that were already zero to `expired` in ascending order.
+//
+// The loop has no branches on the timers. With AVX-512 the expired
+// indices are written with a compress store, with AVX2 they are
+// packed with a permute from a table, and otherwise they are written
+// unconditionally with only the count advancing.
+template <Timer T>
+void count_down(std::span<T> timers, std::vector<std::uint32_t>& expired) {
+  std::size_t size = timers.size();
+  // Vector stores may write a full vector past the last index.
+  expired.resize(size + 16);
+  std::uint32_t* out = expired.data();
+  std::size_t count = 0;
+  std::size_t i = 0;
+
+#if defined(__AVX512F__)
+  auto* data = reinterpret_cast<char*>(timers.data());
+  __m512i const one = _mm512_set1_epi32(1);
+  __m512i const lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                          8, 9, 10, 11, 12, 13, 14, 15);
+  for (; i + 16 <= size; i += 16) {
+    void* p = data + i * sizeof(T);
+    __m512i t = _mm512_loadu_si512(p);
+    __mmask16 is_zero = _mm512_cmpeq_epi32_mask(t, _mm512_setzero_si512());
+    t = _mm512_mask_sub_epi32(t, static_cast<__mmask16>(~is_zero), t, one);
+    _mm512_storeu_si512(p, t);
+
+    __m512i index = _mm512_add_epi32(lanes, _mm512_set1_epi32(i));
+    _mm512_mask_compressstoreu_epi32(out + count, is_zero, index);
+    count += std::popcount(static_cast<unsigned>(is_zero));
+  }
+#elif defined(__AVX2__)
+  auto* data = reinterpret_cast<char*>(timers.data());
+  __m256i const zero = _mm256_setzero_si256();
+  for (; i + 8 <= size; i += 8) {
+    auto* p = reinterpret_cast<__m256i*>(data + i * sizeof(T));
+    __m256i t = _mm256_loadu_si256(p);
+    __m256i is_zero = _mm256_cmpeq_epi32(t, zero);
+    // Add -1 to the lanes that are not zero.
+    t = _mm256_add_epi32(t, _mm256_andnot_si256(is_zero,
+                                                _mm256_set1_epi32(-1)));
+    _mm256_storeu_si256(p, t);
+
+    unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(is_zero));
+    auto const& lanes = detail::compress_lanes[mask];
+    __m256i perm = _mm256_loadu_si256(
+      reinterpret_cast<__m256i const*>(lanes.data()));
+    __m256i index = _mm256_add_epi32(perm, _mm256_set1_epi32(i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + count), index);
+    count += std::popcount(mask);
+  }
+#endif
+
+  for (; i < size; ++i) {
+    std::uint32_t t;
+    std::memcpy(&t, &timers[i], sizeof(t));
+    bool is_zero = t == 0;
+    t -= !is_zero;
+    std::memcpy(&timers[i], &t, sizeof(t));
+    out[count] = static_cast<std::uint32_t>(i);
+    count += is_zero;
+  }
+
+  expired.resize(count);
+}
+
+}  // namespace abmoid
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef ABMOID_CSR_MATRIX_HPP
+#define ABMOID_CSR_MATRIX_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace abmoid {
+
+// A sparse matrix in compressed sparse row form.
+//
+// The entries of row i are columns[j] and values[j] for j in
+// [row_offsets[i], row_offsets[i + 1]) in ascending column order.
+class csr_matrix {
+  std::size_t num_rows = 0;
+  std::size_t num_cols = 0;
+  std::vector<std::size_t> row_offsets{0};
+  std::vector<std::uint32_t> columns;
+  std::vector<double> values;
+
+public:
+  struct entry {
+    std::uint32_t row;
+    std::uint32_t col;
+    double value;
+  };
+
+  csr_matrix() = default;
+
+  // Entries at the same position are summed.
+  csr_matrix(std::size_t num_rows, std::size_t num_cols,
+             std::vector<entry> entries)
+    : num_rows(num_rows),
+      num_cols(num_cols)
+  {
+    std::ranges::sort(entries, [](entry const& a, entry const& b) {
+      return a.row != b.row ? a.row < b.row : a.col < b.col;
+    });
+
+    row_offsets.assign(num_rows + 1, 0);
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+      entry const& e = entries[i];
+      assert(e.row < num_rows && e.col < num_cols);
+      bool is_duplicate = i > 0 && entries[i - 1].row == e.row &&
+                          entries[i - 1].col == e.col;
+      if (is_duplicate) {
+        values.back() += e.value;
+        continue;
+      }
+      columns.push_back(e.col);
+      values.push_back(e.value);
+      ++row_offsets[e.row + 1];
+    }
+    for (std::size_t i = 0; i < num_rows; ++i)
+      row_offsets[i + 1] += row_offsets[i];
+  }
+
+  std::size_t rows() const { return num_rows; }
+  std::size_t cols() const { return num_cols; }
+  std::size_t non_zeros() const { return values.size(); }
+
+  std::span<std::size_t const> get_row_offsets() const { return row_offsets; }
+  std::span<std::uint32_t const> get_columns() const { return columns; }
+  std::span<double const> get_values() const { return values; }
+  // Values can change while the sparsity pattern stays fixed.
+  std::span<double> get_values() { return values; }
+
+  // y = A x
+  void multiply(std::span<double const> x, std::span<double> y) const {
+    assert(x.size() == num_cols && y.size() == num_rows);
+    for (std::size_t i = 0; i < num_rows; ++i) {
+      double sum = 0.0;
+      for (std::size_t j = row_offsets[i]; j < row_offsets[i + 1]; ++j)
+        sum += values[j] * x[columns[j]];
+      y[i] = sum;
+    }
+  }
+
+  csr_matrix transpose() const {
+    std::vector<entry> entries;
+    entries.reserve(values.size());
+    for (std::uint32_t i = 0; i < num_rows; ++i)
+      for (std::size_t j = row_offsets[i]; j < row_offsets[i + 1]; ++j)
+        entries.push_back({columns[j], i, values[j]});
+    return csr_matrix(num_cols, num_rows, std::move(entries));
+  }
+};
+
+}  // namespace abmoid
+
+#endif
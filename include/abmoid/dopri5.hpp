@@ -0,0 +1,198 @@
+#ifndef ABMOID_DOPRI5_HPP
+#define ABMOID_DOPRI5_HPP
+
+#include <abmoid/rk4.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+
+namespace abmoid {
+
+struct tolerance {
+  double abs = 1e-6;
+  double rel = 1e-6;
+};
+
+struct step_stats {
+  std::size_t accepted = 0;
+  std::size_t rejected = 0;
+  // Calls to the system function.
+  std::size_t evaluations = 0;
+};
+
+// Root mean square of err scaled per component by
+// tol.abs + tol.rel * max(|x|, |x_new|).
+//
+// States that are not ranges of numbers provide their own
+// error_norm with this signature to be found by ADL.
+template <std::ranges::forward_range State>
+double error_norm(State const& err, State const& x, State const& x_new,
+                  tolerance tol) {
+  double sum = 0.0;
+  std::size_t n = 0;
+  auto x_itr = std::ranges::begin(x);
+  auto x_new_itr = std::ranges::begin(x_new);
+  for (double e : err) {
+    double scale = tol.abs + tol.rel * std::max(std::abs(*x_itr),
+                                                std::abs(*x_new_itr));
+    sum += (e / scale) * (e / scale);
+    ++n;
+    ++x_itr;
+    ++x_new_itr;
+  }
+  return n == 0 ? 0.0 : std::sqrt(sum / n);
+}
+
+template <typename State>
+concept ErrorNormState = requires(State const& x, tolerance tol) {
+  { error_norm(x, x, x, tol) } -> std::convertible_to<double>;
+};
+
+// Integrate from t = 0 with the Dormand-Prince 5(4) method choosing
+// each step so the local error estimate stays within tol, and call
+// result(x, t) at each of the ascending output_times.
+//
+// Output between steps comes from the method's 4th order continuous
+// extension so the step size does not depend on the output times.
+// Like rk4, fn(t, x) returns dx/dt and State needs + and a
+// scalar *. Throws if the step size underflows.
+template <typename SystemFn,
+          ErrorNormState State,
+          ResultVisitorFn<State> ResultVisitorFn,
+          std::ranges::input_range Times>
+step_stats dopri5(SystemFn&& fn, ResultVisitorFn&& result,
+                  State initial_state, Times&& output_times,
+                  tolerance tol = {}) {
+  // Butcher tableau.
+  constexpr double c2 = 1.0 / 5, c3 = 3.0 / 10, c4 = 4.0 / 5,
+                   c5 = 8.0 / 9;
+  constexpr double a21 = 1.0 / 5;
+  constexpr double a31 = 3.0 / 40, a32 = 9.0 / 40;
+  constexpr double a41 = 44.0 / 45, a42 = -56.0 / 15, a43 = 32.0 / 9;
+  constexpr double a51 = 19372.0 / 6561, a52 = -25360.0 / 2187,
+                   a53 = 64448.0 / 6561, a54 = -212.0 / 729;
+  constexpr double a61 = 9017.0 / 3168, a62 = -355.0 / 33,
+                   a63 = 46732.0 / 5247, a64 = 49.0 / 176,
+                   a65 = -5103.0 / 18656;
+  // 5th order weights which are also the last row (FSAL).
+  constexpr double b1 = 35.0 / 384, b3 = 500.0 / 1113, b4 = 125.0 / 192,
+                   b5 = -2187.0 / 6784, b6 = 11.0 / 84;
+  // Difference from the embedded 4th order weights.
+  constexpr double e1 = 71.0 / 57600, e3 = -71.0 / 16695,
+                   e4 = 71.0 / 1920, e5 = -17253.0 / 339200,
+                   e6 = 22.0 / 525, e7 = -1.0 / 40;
+  // Dense output.
+  constexpr double d1 = -12715105075.0 / 11282082432.0,
+                   d3 = 87487479700.0 / 32700410799.0,
+                   d4 = -10690763975.0 / 1880347072.0,
+                   d5 = 701980252875.0 / 199316789632.0,
+                   d6 = -1453857185.0 / 822651844.0,
+                   d7 = 69997945.0 / 29380423.0;
+
+  // Step size control.
+  constexpr double safety = 0.9;
+  constexpr double min_factor = 0.2;
+  constexpr double max_factor = 10.0;
+
+  step_stats stats;
+  auto eval = [&](time_t t, State const& x) {
+    ++stats.evaluations;
+    return fn(t, x);
+  };
+
+  auto time_itr = std::ranges::begin(output_times);
+  auto time_end = std::ranges::end(output_times);
+  if (time_itr == time_end)
+    return stats;
+
+  time_t t = 0.0;
+  State x = initial_state;
+  State k1 = eval(t, x);
+
+  // Initial step size following Hairer, Norsett and Wanner.
+  time_t h = 0.0;
+  {
+    double norm_x = error_norm(x, x, x, tol);
+    double norm_k1 = error_norm(k1, x, x, tol);
+    double h0 = (norm_x < 1e-5 || norm_k1 < 1e-5) ? 1e-6
+                                                  : 0.01 * norm_x / norm_k1;
+    State k = eval(t + h0, x + h0 * k1);
+    double norm_dk = error_norm(k + -1.0 * k1, x, x, tol) / h0;
+    double d = std::max(norm_k1, norm_dk);
+    double h1 = d <= 1e-15 ? std::max(1e-6, h0 * 1e-3)
+                           : std::pow(0.01 / d, 1.0 / 5);
+    h = std::min(100.0 * h0, h1);
+  }
+
+  bool was_rejected = false;
+  while (true) {
+    // Report every output time reached so far.
+    while (time_itr != time_end && *time_itr <= t) {
+      result(x, *time_itr);
+      ++time_itr;
+    }
+    if (time_itr == time_end)
+      break;
+
+    State k2 = eval(t + c2 * h, x + h * (a21 * k1));
+    State k3 = eval(t + c3 * h, x + h * (a31 * k1 + a32 * k2));
+    State k4 = eval(t + c4 * h, x + h * (a41 * k1 + a42 * k2 + a43 * k3));
+    State k5 = eval(t + c5 * h, x + h * (a51 * k1 + a52 * k2 + a53 * k3 +
+                                         a54 * k4));
+    State k6 = eval(t + h, x + h * (a61 * k1 + a62 * k2 + a63 * k3 +
+                                    a64 * k4 + a65 * k5));
+    State x_new = x + h * (b1 * k1 + b3 * k3 + b4 * k4 + b5 * k5 + b6 * k6);
+    State k7 = eval(t + h, x_new);
+
+    State err = h * (e1 * k1 + e3 * k3 + e4 * k4 + e5 * k5 + e6 * k6 +
+                     e7 * k7);
+    double err_norm = error_norm(err, x, x_new, tol);
+    double factor = err_norm == 0.0
+      ? max_factor
+      : std::clamp(safety * std::pow(err_norm, -1.0 / 5),
+                   min_factor, max_factor);
+
+    if (!(err_norm <= 1.0)) {
+      ++stats.rejected;
+      was_rejected = true;
+      h *= std::min(1.0, factor);
+      if (t + h == t)
+        throw std::runtime_error("dopri5: step size underflow");
+      continue;
+    }
+
+    // Interpolate the output times within the step.
+    State dx = x_new + -1.0 * x;
+    State r3 = h * k1 + -1.0 * dx;
+    State r4 = dx + -h * k7 + -1.0 * r3;
+    State r5 = h * (d1 * k1 + d3 * k3 + d4 * k4 + d5 * k5 + d6 * k6 +
+                    d7 * k7);
+    while (time_itr != time_end && *time_itr < t + h) {
+      double theta = (*time_itr - t) / h;
+      double theta_1 = 1.0 - theta;
+      result(x + theta * (dx + theta_1 * (r3 + theta * (r4 +
+                                            theta_1 * r5))),
+             *time_itr);
+      ++time_itr;
+    }
+
+    ++stats.accepted;
+    t += h;
+    x = x_new;
+    k1 = k7;
+    // Do not grow the step right after a rejection.
+    h *= was_rejected ? std::min(1.0, factor) : factor;
+    was_rejected = false;
+  }
+
+  return stats;
+}
+
+}  // namespace abmoid
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef ABMOID_DUAL_HPP
+#define ABMOID_DUAL_HPP
+
+#include <array>
+#include <cmath>
+#include <compare>
+#include <cstddef>
+
+namespace abmoid {
+
+// A number carrying its derivatives with respect to N parameters for
+// forward mode automatic differentiation.
+//
+// A model written over a scalar type integrated with dual numbers
+// gives the derivatives of each state with respect to the parameters
+// in the same pass as the state itself, the same as integrating the
+// forward sensitivity equations alongside it.
+template <std::size_t N>
+struct dual {
+  double value = 0.0;
+  std::array<double, N> derivatives{};
+
+  dual() = default;
+
+  // A constant.
+  dual(double value)
+    : value(value)
+  { }
+
+  // The parameter with index i.
+  static dual variable(double value, std::size_t i) {
+    dual x(value);
+    x.derivatives[i] = 1.0;
+    return x;
+  }
+
+  dual operator-() const {
+    dual x;
+    x.value = -value;
+    for (std::size_t i = 0; i < N; ++i)
+      x.derivatives[i] = -derivatives[i];
+    return x;
+  }
+
+  dual& operator+=(dual const& other) {
+    value += other.value;
+    for (std::size_t i = 0; i < N; ++i)
+      derivatives[i] += other.derivatives[i];
+    return *this;
+  }
+
+  dual& operator-=(dual const& other) {
+    value -= other.value;
+    for (std::size_t i = 0; i < N; ++i)
+      derivatives[i] -= other.derivatives[i];
+    return *this;
+  }
+
+  dual& operator*=(dual const& other) {
+    for (std::size_t i = 0; i < N; ++i)
+      derivatives[i] = derivatives[i] * other.value +
+                       value * other.derivatives[i];
+    value *= other.value;
+    return *this;
+  }
+
+  dual& operator/=(dual const& other) {
+    double inverse = 1.0 / other.value;
+    value *= inverse;
+    for (std::size_t i = 0; i < N; ++i)
+      derivatives[i] = (derivatives[i] - value * other.derivatives[i]) *
+                       inverse;
+    return *this;
+  }
+
+  dual& operator+=(double k) {
+    value += k;
+    return *this;
+  }
+
+  dual& operator-=(double k) {
+    value -= k;
+    return *this;
+  }
+
+  dual& operator*=(double k) {
+    value *= k;
+    for (double& d : derivatives)
+      d *= k;
+    return *this;
+  }
+
+  dual& operator/=(double k) {
+    return *this *= 1.0 / k;
+  }
+
+  friend dual operator+(dual x, dual const& y) { return x += y; }
+  friend dual operator-(dual x, dual const& y) { return x -= y; }
+  friend dual operator*(dual x, dual const& y) { return x *= y; }
+  friend dual operator/(dual x, dual const& y) { return x /= y; }
+
+  friend dual operator+(dual x, double k) { return x += k; }
+  friend dual operator+(double k, dual x) { return x += k; }
+  friend dual operator-(dual x, double k) { return x -= k; }
+  friend dual operator-(double k, dual const& x) { return -x + k; }
+  friend dual operator*(dual x, double k) { return x *= k; }
+  friend dual operator*(double k, dual x) { return x *= k; }
+  friend dual operator/(dual x, double k) { return x /= k; }
+  friend dual operator/(double k, dual const& x) { return dual(k) /= x; }
+
+  // Compare values only.
+  friend bool operator==(dual const& x, dual const& y) {
+    return x.value == y.value;
+  }
+  friend std::partial_ordering operator<=>(dual const& x, dual const& y) {
+    return x.value <=> y.value;
+  }
+};
+
+inline double value_of(double x) {
+  return x;
+}
+
+template <std::size_t N>
+double value_of(dual<N> const& x) {
+  return x.value;
+}
+
+namespace detail {
+// f(x) given f(x.value) and f'(x.value).
+template <std::size_t N>
+dual<N> chain(dual<N> const& x, double f, double df) {
+  dual<N> y(f);
+  for (std::size_t i = 0; i < N; ++i)
+    y.derivatives[i] = df * x.derivatives[i];
+  return y;
+}
+}
+
+template <std::size_t N>
+dual<N> exp(dual<N> const& x) {
+  double e = std::exp(x.value);
+  return detail::chain(x, e, e);
+}
+
+template <std::size_t N>
+dual<N> expm1(dual<N> const& x) {
+  return detail::chain(x, std::expm1(x.value), std::exp(x.value));
+}
+
+template <std::size_t N>
+dual<N> log(dual<N> const& x) {
+  return detail::chain(x, std::log(x.value), 1.0 / x.value);
+}
+
+template <std::size_t N>
+dual<N> sqrt(dual<N> const& x) {
+  double s = std::sqrt(x.value);
+  return detail::chain(x, s, 0.5 / s);
+}
+
+template <std::size_t N>
+dual<N> pow(dual<N> const& x, double p) {
+  return detail::chain(x, std::pow(x.value, p),
+                       p * std::pow(x.value, p - 1.0));
+}
+
+template <std::size_t N>
+dual<N> abs(dual<N> const& x) {
+  return x.value < 0.0 ? -x : x;
+}
+
+}  // namespace abmoid
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef ABMOID_ENSEMBLE_HPP
+#define ABMOID_ENSEMBLE_HPP
+
+#include <abmoid/rk4.hpp>
+#include <abmoid/thread_pool.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace abmoid {
+
+// States of a run of scenarios stored component-major so that
+// each component is a contiguous row with one lane per scenario.
+template <typename T>
+class lanes_view {
+  std::span<T> data;
+  std::size_t lanes;
+
+public:
+  lanes_view(std::span<T> data, std::size_t lanes)
+    : data(data),
+      lanes(lanes)
+  { }
+
+  // Number of scenarios.
+  std::size_t size() const { return lanes; }
+
+  std::size_t components() const {
+    return lanes == 0 ? 0 : data.size() / lanes;
+  }
+
+  // Component c of each scenario.
+  std::span<T> operator[](std::size_t c) const {
+    return data.subspan(c * lanes, lanes);
+  }
+};
+
+// fn(t, first, x, dxdt) writes dx/dt for the scenarios
+// [first, first + x.size()) with one lane per scenario.
+template <typename F>
+concept EnsembleSystemFn = std::invocable<F, time_t, std::size_t,
+                                          lanes_view<double const>,
+                                          lanes_view<double>>;
+
+template <typename F>
+concept EnsembleVisitorFn = std::invocable<F, std::size_t,
+                                           lanes_view<double const>,
+                                           time_t>;
+
+// Integrate many independent scenarios of the same system in
+// lockstep with rk4.
+//
+// x holds the state of every scenario with component c of scenario s
+// at x[c * scenarios + s] and is integrated in place. The scenarios
+// are split into chunks of chunk_size which the threads of the pool
+// integrate independently, each in its own component-major buffer,
+// so fn can update a whole row of lanes with one vectorized loop.
+// result(first, x, t) is called as scheduled in rk4 from the thread
+// running the chunk.
+template <EnsembleSystemFn Fn, EnsembleVisitorFn ResultVisitorFn,
+          OutputSchedule Schedule = every_k_steps>
+void ensemble_rk4(thread_pool& pool, Fn&& fn, ResultVisitorFn&& result,
+                  std::span<double> x, std::size_t components,
+                  time_step dt, std::size_t step_count,
+                  Schedule schedule = {}, std::size_t chunk_size = 256) {
+  assert(components > 0 && x.size() % components == 0);
+  std::size_t scenarios = x.size() / components;
+  chunk_size = std::max<std::size_t>(chunk_size, 1);
+  std::size_t num_chunks = (scenarios + chunk_size - 1) / chunk_size;
+
+  // Reused by every chunk a thread runs.
+  std::vector<rk4_workspace> workspaces(pool.size());
+  std::vector<std::vector<double>> buffers(pool.size());
+
+  pool.parallel_for(num_chunks, [&](std::size_t chunk,
+                                    unsigned thread_index) {
+    std::size_t first = chunk * chunk_size;
+    std::size_t lanes = std::min(chunk_size, scenarios - first);
+    std::vector<double>& buffer = buffers[thread_index];
+    buffer.resize(components * lanes);
+
+    for (std::size_t c = 0; c < components; ++c)
+      std::ranges::copy(x.subspan(c * scenarios + first, lanes),
+                        buffer.begin() + c * lanes);
+
+    auto chunk_fn = [&](time_t t, std::span<double const> state,
+                        std::span<double> dxdt) {
+      fn(t, first, lanes_view<double const>(state, lanes),
+         lanes_view<double>(dxdt, lanes));
+    };
+    auto chunk_result = [&](std::span<double const> state, time_t t) {
+      result(first, lanes_view<double const>(state, lanes), t);
+    };
+    rk4(chunk_fn, chunk_result, std::span<double>(buffer), dt, step_count,
+        workspaces[thread_index], schedule);
+
+    for (std::size_t c = 0; c < components; ++c)
+      std::ranges::copy(buffer.begin() + c * lanes,
+                        buffer.begin() + (c + 1) * lanes,
+                        x.begin() + c * scenarios + first);
+  });
+}
+
+}  // namespace abmoid
+
+#endif
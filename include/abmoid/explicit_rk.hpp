@@ -0,0 +1,324 @@
+#ifndef ABMOID_EXPLICIT_RK_HPP
+#define ABMOID_EXPLICIT_RK_HPP
+
+#include <abmoid/rk4.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <ranges>
+#include <span>
+#include <utility>
+
+namespace abmoid {
+
+// The coefficients of an explicit Runge-Kutta method where stage i
+// is evaluated at t + c[i] dt with the state
+// x + dt sum_{j < i} a[i][j] k_j and the step is x + dt sum_j b[j] k_j.
+template <std::size_t Stages>
+struct butcher_tableau {
+  static constexpr std::size_t stages = Stages;
+
+  std::array<std::array<double, Stages>, Stages> a{};
+  std::array<double, Stages> b{};
+  std::array<double, Stages> c{};
+
+  constexpr bool is_explicit() const {
+    for (std::size_t i = 0; i < Stages; ++i)
+      for (std::size_t j = i; j < Stages; ++j)
+        if (a[i][j] != 0.0)
+          return false;
+    return true;
+  }
+
+  // The last stage is evaluated at the end of the step so it is the
+  // first stage of the next.
+  constexpr bool is_fsal() const {
+    return c[Stages - 1] == 1.0 && a[Stages - 1] == b;
+  }
+};
+
+namespace tableaus {
+inline constexpr butcher_tableau<1> euler{
+  .a = {{{0.0}}},
+  .b = {1.0},
+  .c = {0.0}};
+
+inline constexpr butcher_tableau<2> heun{
+  .a = {{{0.0, 0.0},
+         {1.0, 0.0}}},
+  .b = {1.0 / 2, 1.0 / 2},
+  .c = {0.0, 1.0}};
+
+// Strong stability preserving third order method of Shu and Osher.
+inline constexpr butcher_tableau<3> ssprk3{
+  .a = {{{0.0, 0.0, 0.0},
+         {1.0, 0.0, 0.0},
+         {1.0 / 4, 1.0 / 4, 0.0}}},
+  .b = {1.0 / 6, 1.0 / 6, 2.0 / 3},
+  .c = {0.0, 1.0, 1.0 / 2}};
+
+inline constexpr butcher_tableau<4> rk4{
+  .a = {{{0.0, 0.0, 0.0, 0.0},
+         {1.0 / 2, 0.0, 0.0, 0.0},
+         {0.0, 1.0 / 2, 0.0, 0.0},
+         {0.0, 0.0, 1.0, 0.0}}},
+  .b = {1.0 / 6, 1.0 / 3, 1.0 / 3, 1.0 / 6},
+  .c = {0.0, 1.0 / 2, 1.0 / 2, 1.0}};
+
+// The fifth order solution of Dormand-Prince 5(4) as in dopri5 with
+// a fixed step.
+inline constexpr butcher_tableau<7> rk45{
+  .a = {{{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
+         {1.0 / 5, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
+         {3.0 / 40, 9.0 / 40, 0.0, 0.0, 0.0, 0.0, 0.0},
+         {44.0 / 45, -56.0 / 15, 32.0 / 9, 0.0, 0.0, 0.0, 0.0},
+         {19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729,
+          0.0, 0.0, 0.0},
+         {9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176,
+          -5103.0 / 18656, 0.0, 0.0},
+         {35.0 / 384, 0.0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784,
+          11.0 / 84, 0.0}}},
+  .b = {35.0 / 384, 0.0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784,
+        11.0 / 84, 0.0},
+  .c = {0.0, 1.0 / 5, 3.0 / 10, 4.0 / 5, 8.0 / 9, 1.0, 1.0}};
+
+// The sixth order solution of Verner's 6(5) pair.
+inline constexpr butcher_tableau<8> verner6{
+  .a = {{{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
+         {1.0 / 6, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
+         {4.0 / 75, 16.0 / 75, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
+         {5.0 / 6, -8.0 / 3, 5.0 / 2, 0.0, 0.0, 0.0, 0.0, 0.0},
+         {-165.0 / 64, 55.0 / 6, -425.0 / 64, 85.0 / 96,
+          0.0, 0.0, 0.0, 0.0},
+         {12.0 / 5, -8.0, 4015.0 / 612, -11.0 / 36, 88.0 / 255,
+          0.0, 0.0, 0.0},
+         {-8263.0 / 15000, 124.0 / 75, -643.0 / 680, -81.0 / 250,
+          2484.0 / 10625, 0.0, 0.0, 0.0},
+         {3501.0 / 1720, -300.0 / 43, 297275.0 / 52632, -319.0 / 2322,
+          24068.0 / 84065, 0.0, 3850.0 / 26703, 0.0}}},
+  .b = {3.0 / 40, 0.0, 875.0 / 2244, 23.0 / 72, 264.0 / 1955, 0.0,
+        125.0 / 11592, 43.0 / 616},
+  .c = {0.0, 1.0 / 6, 4.0 / 15, 2.0 / 3, 5.0 / 6, 1.0, 1.0 / 15, 1.0}};
+}
+
+namespace detail {
+// Indices of the nonzero weights among the first End.
+template <auto Weights, std::size_t End>
+constexpr auto nonzero_indices() {
+  constexpr std::size_t count = [] {
+    std::size_t count = 0;
+    for (std::size_t j = 0; j < End; ++j)
+      count += Weights[j] != 0.0;
+    return count;
+  }();
+  std::array<std::size_t, count> indices{};
+  for (std::size_t j = 0, i = 0; j < End; ++j)
+    if (Weights[j] != 0.0)
+      indices[i++] = j;
+  return indices;
+}
+
+// sum_j Weights[j] k[j][i] over the nonzero weights among the first End
+// with each weight a constant.
+template <auto Weights, std::size_t End, typename Stages>
+inline double weighted_sum(Stages const& k, std::size_t i) {
+  static constexpr auto indices = nonzero_indices<Weights, End>();
+  static_assert(indices.size() > 0);
+  return [&]<std::size_t... J>(std::index_sequence<J...>) {
+    return (... + (Weights[indices[J]] * k[indices[J]][i]));
+  }(std::make_index_sequence<indices.size()>{});
+}
+
+// sum_j (dt Weights[j]) k[j] for value states.
+template <auto Weights, std::size_t End, typename State>
+inline State weighted_sum(std::span<State const> k, double dt) {
+  static constexpr auto indices = nonzero_indices<Weights, End>();
+  static_assert(indices.size() > 0);
+  return [&]<std::size_t... J>(std::index_sequence<J...>) {
+    return State((... + ((dt * Weights[indices[J]]) * k[indices[J]])));
+  }(std::make_index_sequence<indices.size()>{});
+}
+
+template <std::size_t Count, typename F>
+inline void unroll(F&& f) {
+  [&]<std::size_t... I>(std::index_sequence<I...>) {
+    (f(std::integral_constant<std::size_t, I>{}), ...);
+  }(std::make_index_sequence<Count>{});
+}
+}
+
+// Integrate with the explicit Runge-Kutta method of Tableau calling
+// result(x, t) as scheduled like rk4.
+//
+// The stages are unrolled and stages with zero weights are skipped
+// at compile time so each method is a straight line of evaluations.
+template <butcher_tableau Tableau,
+          std::semiregular State,
+          SystemFn<State> Fn,
+          ResultVisitorFn<State> ResultVisitorFn,
+          OutputSchedule Schedule = every_k_steps>
+  requires (Tableau.is_explicit())
+void explicit_rk(Fn&& fn, ResultVisitorFn&& result, State initial_state,
+                 time_step dt_, std::size_t step_count,
+                 Schedule schedule = {}) {
+  constexpr std::size_t stages = Tableau.stages;
+  if (step_count < 1)
+    return;
+
+  auto dt = dt_.value;
+  State x = initial_state;
+  time_t t = 0.0;
+  std::array<State, stages> k;
+  k[0] = fn(t, x);
+  auto time_itr = std::ranges::begin(detail::schedule_times(schedule));
+  auto time_end = std::ranges::end(detail::schedule_times(schedule));
+  for (std::size_t i = 0; i < step_count; ++i) {
+    detail::unroll<stages - 1>([&](auto j) {
+      constexpr std::size_t s = j + 1;
+      k[s] = fn(t + Tableau.c[s] * dt,
+                x + detail::weighted_sum<Tableau.a[s], s>(
+                      std::span<State const>(k), dt));
+    });
+    State next_x = x + detail::weighted_sum<Tableau.b, stages>(
+                         std::span<State const>(k), dt);
+    bool is_last = i + 1 == step_count;
+    State next_k_0{};
+    if constexpr (Tableau.is_fsal())
+      next_k_0 = k[stages - 1];
+    else if (std::same_as<Schedule, at_times> || !is_last)
+      next_k_0 = fn(t + dt, next_x);
+
+    if constexpr (std::same_as<Schedule, every_k_steps>) {
+      if (i % schedule.k == 0)
+        result(x, t);
+    } else {
+      for (; time_itr != time_end &&
+             (*time_itr < t + dt || (is_last && *time_itr <= step_count * dt));
+           ++time_itr) {
+        if (*time_itr < t)
+          continue;
+        auto [h_00, h_10, h_01, h_11] =
+          detail::hermite_weights((*time_itr - t) / dt);
+        result(h_00 * x + (h_10 * dt) * k[0] + h_01 * next_x +
+               (h_11 * dt) * next_k_0,
+               *time_itr);
+      }
+    }
+
+    x = next_x;
+    k[0] = next_k_0;
+    t += dt;
+  }
+}
+
+// Integrate x in place with the explicit Runge-Kutta method of
+// Tableau like the in-place rk4.
+//
+// Each stage state and the final update is a single loop over the
+// components summing only the nonzero weights.
+template <butcher_tableau Tableau,
+          InPlaceSystemFn Fn,
+          ResultVisitorFn<std::span<double const>> ResultVisitorFn,
+          OutputSchedule Schedule = every_k_steps>
+  requires (Tableau.is_explicit())
+void explicit_rk(Fn&& fn, ResultVisitorFn&& result, std::span<double> x,
+                 time_step dt_, std::size_t step_count,
+                 rk4_workspace& workspace, Schedule schedule = {}) {
+  constexpr std::size_t stages = Tableau.stages;
+  double const dt = dt_.value;
+  std::size_t const n = x.size();
+  // The stages, the derivative at the end of a step when it is not
+  // the last stage, the stage state and the start of a step.
+  auto buffers = workspace.get<stages + 3>(n);
+  std::array<double*, stages + 1> k;
+  for (std::size_t s = 0; s <= stages; ++s)
+    k[s] = buffers[s].data();
+  double* xs = x.data();
+  double* stage = buffers[stages + 1].data();
+  double* xp = buffers[stages + 2].data();
+  constexpr std::size_t end = Tableau.is_fsal() ? stages - 1 : stages;
+
+  auto time_itr = std::ranges::begin(detail::schedule_times(schedule));
+  auto time_end = std::ranges::end(detail::schedule_times(schedule));
+  time_t t = 0.0;
+  if (step_count > 0)
+    fn(t, std::span<double const>(x), std::span(k[0], n));
+  for (std::size_t step = 0; step < step_count; ++step) {
+    std::span<double const> x_const = x;
+    detail::unroll<stages - 1>([&](auto j) {
+      constexpr std::size_t s = j + 1;
+      for (std::size_t i = 0; i < n; ++i)
+        stage[i] = xs[i] + dt * detail::weighted_sum<Tableau.a[s], s>(k, i);
+      fn(t + Tableau.c[s] * dt, std::span<double const>(stage, n),
+         std::span(k[s], n));
+    });
+
+    if constexpr (std::same_as<Schedule, every_k_steps>) {
+      if (step % schedule.k == 0)
+        result(x_const, t);
+    } else {
+      std::ranges::copy(x_const, xp);
+    }
+    if constexpr (Tableau.is_fsal())
+      std::ranges::copy(std::span<double const>(stage, n), xs);
+    else
+      for (std::size_t i = 0; i < n; ++i)
+        xs[i] += dt * detail::weighted_sum<Tableau.b, stages>(k, i);
+
+    // As in the in-place rk4 the derivative at the end of the step
+    // is kept apart from k[0] until any output is interpolated.
+    if constexpr (!Tableau.is_fsal()) {
+      if (std::same_as<Schedule, at_times> || step + 1 < step_count)
+        fn(t + dt, x_const, std::span(k[end], n));
+    }
+    if constexpr (std::same_as<Schedule, at_times>) {
+      bool is_last = step + 1 == step_count;
+      for (; time_itr != time_end &&
+             (*time_itr < t + dt || (is_last && *time_itr <= step_count * dt));
+           ++time_itr) {
+        if (*time_itr < t)
+          continue;
+        auto [h_00, h_10, h_01, h_11] =
+          detail::hermite_weights((*time_itr - t) / dt);
+        for (std::size_t i = 0; i < n; ++i)
+          stage[i] = h_00 * xp[i] + h_10 * dt * k[0][i] +
+                     h_01 * xs[i] + h_11 * dt * k[end][i];
+        result(std::span<double const>(stage, n), *time_itr);
+      }
+    }
+    std::swap(k[0], k[end]);
+    t += dt;
+  }
+}
+
+template <butcher_tableau Tableau,
+          InPlaceSystemFn Fn,
+          ResultVisitorFn<std::span<double const>> ResultVisitorFn,
+          ContiguousState State,
+          OutputSchedule Schedule = every_k_steps>
+  requires (Tableau.is_explicit())
+void explicit_rk(Fn&& fn, ResultVisitorFn&& result, State& x,
+                 time_step dt, std::size_t step_count,
+                 rk4_workspace& workspace, Schedule schedule = {}) {
+  explicit_rk<Tableau>(fn, result, std::span<double>(x), dt, step_count,
+                       workspace, schedule);
+}
+
+template <butcher_tableau Tableau,
+          InPlaceSystemFn Fn,
+          ResultVisitorFn<std::span<double const>> ResultVisitorFn,
+          ContiguousState State,
+          OutputSchedule Schedule = every_k_steps>
+  requires (Tableau.is_explicit())
+void explicit_rk(Fn&& fn, ResultVisitorFn&& result, State& x,
+                 time_step dt, std::size_t step_count,
+                 Schedule schedule = {}) {
+  rk4_workspace workspace;
+  explicit_rk<Tableau>(fn, result, std::span<double>(x), dt, step_count,
+                       workspace, schedule);
+}
+
+}  // namespace abmoid
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef ABMOID_LANE_RNG_HPP
+#define ABMOID_LANE_RNG_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace abmoid {
+
+// Independent xoshiro128+ generators advanced together, one per lane,
+// written as loops over the lanes so the compiler keeps each in a
+// SIMD lane. Each call yields a batch of uniform 32 bit integers.
+template <std::size_t Lanes = 16>
+class lane_rng {
+  alignas(64) std::array<std::uint32_t, Lanes> s0;
+  alignas(64) std::array<std::uint32_t, Lanes> s1;
+  alignas(64) std::array<std::uint32_t, Lanes> s2;
+  alignas(64) std::array<std::uint32_t, Lanes> s3;
+
+  static std::uint64_t splitmix64(std::uint64_t& x) {
+    std::uint64_t z = (x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+  }
+
+public:
+  using batch = std::array<std::uint32_t, Lanes>;
+
+  static constexpr std::size_t lanes = Lanes;
+
+  explicit lane_rng(std::uint64_t seed) {
+    for (std::size_t k = 0; k < Lanes; ++k) {
+      std::uint64_t a = splitmix64(seed);
+      std::uint64_t b = splitmix64(seed);
+      s0[k] = static_cast<std::uint32_t>(a);
+      s1[k] = static_cast<std::uint32_t>(a >> 32);
+      s2[k] = static_cast<std::uint32_t>(b);
+      s3[k] = static_cast<std::uint32_t>(b >> 32);
+    }
+  }
+
+  void next(batch& out) {
+    for (std::size_t k = 0; k < Lanes; ++k) {
+      out[k] = s0[k] + s3[k];
+      std::uint32_t t = s1[k] << 9;
+      s2[k] ^= s0[k];
+      s3[k] ^= s1[k];
+      s1[k] ^= s2[k];
+      s0[k] ^= s3[k];
+      s2[k] ^= t;
+      s3[k] = (s3[k] << 11) | (s3[k] >> 21);
+    }
+  }
+};
+
+}  // namespace abmoid
+
+#endif
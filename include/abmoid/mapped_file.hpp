@@ -0,0 +1,79 @@
+#ifndef ABMOID_MAPPED_FILE_HPP
+#define ABMOID_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace abmoid {
+
+// A whole file mapped read only for formats of fixed size records
+// that are read in place.
+//
+// Errors are thrown as std::runtime_error with the name of the
+// format and the path so a format can check its own header with
+// fail and leave the unmapping to the destructor.
+class mapped_file {
+  std::string format;
+  std::string path;
+  void* data = nullptr;
+  std::size_t size = 0;
+
+public:
+  // A file shorter than min_size, such as the size of a header,
+  // is truncated.
+  mapped_file(std::string path, std::string format,
+              std::size_t min_size = 0)
+    : format(std::move(format)),
+      path(std::move(path))
+  {
+    int fd = ::open(this->path.c_str(), O_RDONLY);
+    if (fd < 0)
+      fail("cannot open");
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+      ::close(fd);
+      fail("cannot stat");
+    }
+    size = info.st_size;
+    if (size < min_size) {
+      ::close(fd);
+      fail("truncated");
+    }
+    // An empty file has nothing to map.
+    if (size > 0)
+      data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      data = nullptr;
+      fail("cannot map");
+    }
+  }
+
+  mapped_file(mapped_file const&) = delete;
+  mapped_file& operator=(mapped_file const&) = delete;
+
+  ~mapped_file() {
+    if (data)
+      ::munmap(data, size);
+  }
+
+  std::span<std::byte const> get_bytes() const {
+    return {static_cast<std::byte const*>(data), size};
+  }
+
+  [[noreturn]] void fail(char const* what) const {
+    throw std::runtime_error(format + ": " + path + ": " + what);
+  }
+};
+
+}
+
+#endif
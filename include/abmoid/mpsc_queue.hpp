@@ -0,0 +1,119 @@
+#ifndef ABMOID_MPSC_QUEUE_HPP
+#define ABMOID_MPSC_QUEUE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+
+namespace abmoid {
+
+// A bounded lock-free queue with many producers and one consumer.
+//
+// Each cell carries a sequence number telling whose turn it is
+// so producers only contend on claiming a position and the consumer
+// never takes a lock. When the queue is full, push blocks which
+// holds producers back to the pace of the consumer.
+template <typename T>
+class mpsc_queue {
+  struct cell {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  static constexpr std::size_t cache_line = 64;
+
+  std::unique_ptr<cell[]> cells;
+  std::size_t mask;
+  // Next position for producers to claim.
+  alignas(cache_line) std::atomic<std::size_t> tail = 0;
+  // Next position for the consumer to take.
+  alignas(cache_line) std::atomic<std::size_t> head = 0;
+
+public:
+  // Capacity is rounded up to a power of two.
+  explicit mpsc_queue(std::size_t capacity)
+    : cells(new cell[std::bit_ceil(std::max<std::size_t>(capacity, 2))]),
+      mask(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1)
+  {
+    for (std::size_t i = 0; i <= mask; ++i)
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  std::size_t capacity() const {
+    return mask + 1;
+  }
+
+  bool try_push(T const& value) {
+    std::size_t pos = tail.load(std::memory_order_relaxed);
+    cell* c;
+    while (true) {
+      c = &cells[pos & mask];
+      std::size_t seq = c->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(seq) -
+                  static_cast<std::intptr_t>(pos);
+      if (diff == 0) {
+        if (tail.compare_exchange_weak(pos, pos + 1,
+                                       std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        // The consumer has not taken the value from a lap ago.
+        return false;
+      } else {
+        pos = tail.load(std::memory_order_relaxed);
+      }
+    }
+
+    c->value = value;
+    c->sequence.store(pos + 1, std::memory_order_release);
+    tail.notify_one();
+    return true;
+  }
+
+  // Block while the queue is full.
+  void push(T const& value) {
+    while (!try_push(value)) {
+      std::size_t h = head.load(std::memory_order_acquire);
+      if (tail.load(std::memory_order_relaxed) - h > mask)
+        head.wait(h, std::memory_order_acquire);
+      else
+        std::this_thread::yield();
+    }
+  }
+
+  // Only the consumer may pop.
+  bool try_pop(T& value) {
+    std::size_t pos = head.load(std::memory_order_relaxed);
+    cell& c = cells[pos & mask];
+    if (c.sequence.load(std::memory_order_acquire) != pos + 1)
+      return false;
+
+    value = std::move(c.value);
+    // Hand the cell to the producers of the next lap.
+    c.sequence.store(pos + mask + 1, std::memory_order_release);
+    head.store(pos + 1, std::memory_order_release);
+    head.notify_all();
+    return true;
+  }
+
+  // Block while the queue is empty.
+  void pop(T& value) {
+    while (!try_pop(value)) {
+      std::size_t t = tail.load(std::memory_order_acquire);
+      if (t == head.load(std::memory_order_relaxed))
+        tail.wait(t, std::memory_order_acquire);
+      else
+        // A producer has claimed a position but not filled it yet.
+        std::this_thread::yield();
+    }
+  }
+};
+
+}  // namespace abmoid
+
+#endif
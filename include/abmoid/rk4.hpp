@@ -1,48 +1,247 @@
 #ifndef ABMOID_RK4_HPP
 #define ABMOID_RK4_HPP
 
+#include <algorithm>
+#include <array>
 #include <concepts>
+#include <cstddef>
+#include <ranges>
+#include <span>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace abmoid {
 using time_t = double;
 
+// fn(t, x) returns dx/dt.
 template <typename F, typename State>
-concept SystemFn = std::invocable<F, State, State&, time_t>;
+concept SystemFn = std::invocable<F, time_t, State const&> &&
+  std::convertible_to<std::invoke_result_t<F, time_t, State const&>, State>;
+
+// fn(t, x, dxdt) writes dx/dt for a state of contiguous doubles.
+template <typename F>
+concept InPlaceSystemFn =
+  std::invocable<F, time_t, std::span<double const>, std::span<double>>;
 
 template <typename F, typename State>
 concept ResultVisitorFn = std::invocable<F, State, time_t>;
 
-// TODO State needs to be a "vector".
+// Contiguous doubles such as std::array, std::vector or std::span.
+template <typename State>
+concept ContiguousState = std::ranges::contiguous_range<State> &&
+  std::ranges::sized_range<State> &&
+  std::same_as<std::ranges::range_value_t<State>, double>;
 
 struct time_step {
   double value;
 };
 
-template <typename SystemFn,
-          std::semiregular State,
-          ResultVisitorFn<State> ResultVisitorFn>
-void rk4(SystemFn&& fn, ResultVisitorFn&& result, State initial_state,
-         time_step dt_, std::size_t step_count) {
+// Call the result visitor before every k-th step.
+struct every_k_steps {
+  std::size_t k = 1;
+};
+
+// Call the result visitor at each of the ascending times that fall
+// within the integration, interpolating between the ends of a step
+// with the cubic Hermite polynomial through the states and their
+// derivatives there. Each step needs no extra evaluations since the
+// derivative at the end of a step is the first stage of the next.
+struct at_times {
+  std::span<time_t const> times;
+};
+
+template <typename Schedule>
+concept OutputSchedule = std::same_as<Schedule, every_k_steps> ||
+                         std::same_as<Schedule, at_times>;
+
+namespace detail {
+// Cubic Hermite basis at theta for the state and scaled
+// derivative at the start and at the end of a step.
+inline std::array<double, 4> hermite_weights(double theta) {
+  double theta_2 = theta * theta;
+  double theta_3 = theta_2 * theta;
+  return {2.0 * theta_3 - 3.0 * theta_2 + 1.0,
+          theta_3 - 2.0 * theta_2 + theta,
+          -2.0 * theta_3 + 3.0 * theta_2,
+          theta_3 - theta_2};
+}
+
+inline std::span<time_t const> schedule_times(every_k_steps) {
+  return {};
+}
+
+inline std::span<time_t const> schedule_times(at_times schedule) {
+  return schedule.times;
+}
+}
+
+template <std::semiregular State,
+          SystemFn<State> Fn,
+          ResultVisitorFn<State> ResultVisitorFn,
+          OutputSchedule Schedule = every_k_steps>
+void rk4(Fn&& fn, ResultVisitorFn&& result, State initial_state,
+         time_step dt_, std::size_t step_count, Schedule schedule = {}) {
   if (step_count < 1)
     return;
 
   auto dt = dt_.value;
   State prev_val = initial_state;
-  auto t = 0;
-  for (int i = 0; i < step_count; ++i) {
+  time_t t = 0.0;
+  State k_1 = fn(t, prev_val);
+  auto time_itr = std::ranges::begin(detail::schedule_times(schedule));
+  auto time_end = std::ranges::end(detail::schedule_times(schedule));
+  for (std::size_t i = 0; i < step_count; ++i) {
     State const& x = prev_val;
-    State k_1 = fn(t, x);
-    State k_2 = fn(t, x + k_1 * (dt / 2.0));
-    State k_3 = fn(t, x + k_2 * (dt / 2.0));
-    State k_4 = fn(t, x + k_3 * dt);
-    
-    prev_val = prev_val + dt / 6.0 * (k_1 + 2.0 * k_2 + 2.0 * k_3 + k_4);
-    result(x, t);
+    State k_2 = fn(t + dt / 2.0, x + k_1 * (dt / 2.0));
+    State k_3 = fn(t + dt / 2.0, x + k_2 * (dt / 2.0));
+    State k_4 = fn(t + dt, x + k_3 * dt);
+    State next_val = x + dt / 6.0 * (k_1 + 2.0 * k_2 + 2.0 * k_3 + k_4);
+    bool is_last = i + 1 == step_count;
+    State next_k_1 = std::same_as<Schedule, at_times> || !is_last
+                     ? State(fn(t + dt, next_val)) : State{};
+
+    if constexpr (std::same_as<Schedule, every_k_steps>) {
+      if (i % schedule.k == 0)
+        result(x, t);
+    } else {
+      for (; time_itr != time_end &&
+             (*time_itr < t + dt || (is_last && *time_itr <= step_count * dt));
+           ++time_itr) {
+        if (*time_itr < t)
+          continue;
+        auto [h_00, h_10, h_01, h_11] =
+          detail::hermite_weights((*time_itr - t) / dt);
+        result(h_00 * x + (h_10 * dt) * k_1 + h_01 * next_val +
+               (h_11 * dt) * next_k_1,
+               *time_itr);
+      }
+    }
+
+    prev_val = next_val;
+    k_1 = next_k_1;
     t += dt;
   }
 }
 
+// Stage buffers for the in-place integrators kept between calls so that
+// integrating allocates only when the state grows.
+class rk4_workspace {
+  std::vector<double> buffer;
+
+public:
+  // Count buffers each of size n.
+  template <std::size_t Count>
+  std::array<std::span<double>, Count> get(std::size_t n) {
+    if (buffer.size() < Count * n)
+      buffer.resize(Count * n);
+    std::array<std::span<double>, Count> spans;
+    for (std::size_t i = 0; i < Count; ++i)
+      spans[i] = std::span<double>(buffer.data() + i * n, n);
+    return spans;
+  }
+};
+
+// Integrate x in place calling fn(t, x, dxdt) for each stage and
+// result(x, t) as scheduled like the rk4 above.
+//
+// Each stage state and the final update is a single loop
+// over the components with no temporaries.
+template <InPlaceSystemFn Fn,
+          ResultVisitorFn<std::span<double const>> ResultVisitorFn,
+          OutputSchedule Schedule = every_k_steps>
+void rk4(Fn&& fn, ResultVisitorFn&& result, std::span<double> x,
+         time_step dt_, std::size_t step_count, rk4_workspace& workspace,
+         Schedule schedule = {}) {
+  double const dt = dt_.value;
+  std::size_t const n = x.size();
+  auto [k_1, k_2, k_3, k_4, stage, x_prev] = workspace.get<6>(n);
+  double* xs = x.data();
+  double* s = stage.data();
+  double* k1 = k_1.data();
+  double* k2 = k_2.data();
+  double const* k3 = k_3.data();
+  double const* k4 = k_4.data();
+  double* xp = x_prev.data();
+
+  auto axpy = [&](double a, double const* k) {
+    for (std::size_t i = 0; i < n; ++i)
+      s[i] = xs[i] + a * k[i];
+  };
+
+  auto time_itr = std::ranges::begin(detail::schedule_times(schedule));
+  auto time_end = std::ranges::end(detail::schedule_times(schedule));
+  time_t t = 0.0;
+  if (step_count > 0)
+    fn(t, std::span<double const>(x), std::span(k1, n));
+  for (std::size_t step = 0; step < step_count; ++step) {
+    std::span<double const> x_const = x;
+    axpy(dt / 2.0, k1);
+    fn(t + dt / 2.0, std::span<double const>(stage), std::span(k2, n));
+    axpy(dt / 2.0, k2);
+    fn(t + dt / 2.0, std::span<double const>(stage), k_3);
+    axpy(dt, k3);
+    fn(t + dt, std::span<double const>(stage), k_4);
+
+    if constexpr (std::same_as<Schedule, every_k_steps>) {
+      if (step % schedule.k == 0)
+        result(x_const, t);
+    } else {
+      std::ranges::copy(x_const, xp);
+    }
+    for (std::size_t i = 0; i < n; ++i)
+      xs[i] += dt / 6.0 * (k1[i] + 2.0 * k2[i] + 2.0 * k3[i] + k4[i]);
+
+    // The first stage of the next step. With at_times it is also the
+    // derivative at the end of this step, so it goes in k_2 while
+    // k_1 still holds the derivative at the start.
+    if constexpr (std::same_as<Schedule, every_k_steps>) {
+      if (step + 1 < step_count)
+        fn(t + dt, x_const, std::span(k1, n));
+    } else {
+      fn(t + dt, x_const, std::span(k2, n));
+      bool is_last = step + 1 == step_count;
+      for (; time_itr != time_end &&
+             (*time_itr < t + dt || (is_last && *time_itr <= step_count * dt));
+           ++time_itr) {
+        if (*time_itr < t)
+          continue;
+        auto [h_00, h_10, h_01, h_11] =
+          detail::hermite_weights((*time_itr - t) / dt);
+        // The stage buffer is free until the next step.
+        for (std::size_t i = 0; i < n; ++i)
+          s[i] = h_00 * xp[i] + h_10 * dt * k1[i] +
+                 h_01 * xs[i] + h_11 * dt * k2[i];
+        result(std::span<double const>(stage), *time_itr);
+      }
+      std::swap(k1, k2);
+    }
+    t += dt;
+  }
+}
+
+template <InPlaceSystemFn Fn,
+          ResultVisitorFn<std::span<double const>> ResultVisitorFn,
+          ContiguousState State,
+          OutputSchedule Schedule = every_k_steps>
+void rk4(Fn&& fn, ResultVisitorFn&& result, State& x,
+         time_step dt, std::size_t step_count, rk4_workspace& workspace,
+         Schedule schedule = {}) {
+  rk4(fn, result, std::span<double>(x), dt, step_count, workspace,
+      schedule);
+}
+
+template <InPlaceSystemFn Fn,
+          ResultVisitorFn<std::span<double const>> ResultVisitorFn,
+          ContiguousState State,
+          OutputSchedule Schedule = every_k_steps>
+void rk4(Fn&& fn, ResultVisitorFn&& result, State& x,
+         time_step dt, std::size_t step_count, Schedule schedule = {}) {
+  rk4_workspace workspace;
+  rk4(fn, result, std::span<double>(x), dt, step_count, workspace,
+      schedule);
+}
+
 }  // namespace abmoid
 
 #endif
@@ -0,0 +1,371 @@
+#ifndef ABMOID_ROSENBROCK_HPP
+#define ABMOID_ROSENBROCK_HPP
+
+#include <abmoid/csr_matrix.hpp>
+#include <abmoid/rk4.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace abmoid {
+
+// jacobian(t, x, J) writes the n by n Jacobian of the system row-major.
+template <typename F>
+concept DenseJacobianFn =
+  std::invocable<F, time_t, std::span<double const>, std::span<double>>;
+
+// jacobian(t, x, J) writes the values of J keeping its sparsity pattern.
+template <typename F>
+concept SparseJacobianFn =
+  std::invocable<F, time_t, std::span<double const>, csr_matrix&>;
+
+namespace detail {
+// Solves (I - gamma_dt J) y = b for a dense J by LU factorization
+// with partial pivoting.
+class dense_rosenbrock_solver {
+  std::size_t n = 0;
+  std::vector<double> lu;
+  std::vector<std::size_t> pivots;
+
+public:
+  // Storage for the Jacobian which factor overwrites.
+  std::span<double> jacobian(std::size_t size) {
+    n = size;
+    lu.resize(n * n);
+    pivots.resize(n);
+    return lu;
+  }
+
+  void factor(double gamma_dt) {
+    for (std::size_t i = 0; i < n; ++i) {
+      for (std::size_t j = 0; j < n; ++j)
+        lu[i * n + j] *= -gamma_dt;
+      lu[i * n + i] += 1.0;
+    }
+
+    for (std::size_t k = 0; k < n; ++k) {
+      std::size_t pivot = k;
+      for (std::size_t i = k + 1; i < n; ++i)
+        if (std::abs(lu[i * n + k]) > std::abs(lu[pivot * n + k]))
+          pivot = i;
+      if (lu[pivot * n + k] == 0.0)
+        throw std::runtime_error("rosenbrock: singular matrix");
+      pivots[k] = pivot;
+      if (pivot != k)
+        std::swap_ranges(lu.begin() + k * n, lu.begin() + (k + 1) * n,
+                         lu.begin() + pivot * n);
+
+      double inverse = 1.0 / lu[k * n + k];
+      for (std::size_t i = k + 1; i < n; ++i) {
+        double l = lu[i * n + k] *= inverse;
+        for (std::size_t j = k + 1; j < n; ++j)
+          lu[i * n + j] -= l * lu[k * n + j];
+      }
+    }
+  }
+
+  void solve(std::span<double> b) const {
+    for (std::size_t k = 0; k < n; ++k)
+      std::swap(b[k], b[pivots[k]]);
+    for (std::size_t i = 0; i < n; ++i)
+      for (std::size_t j = 0; j < i; ++j)
+        b[i] -= lu[i * n + j] * b[j];
+    for (std::size_t i = n; i-- > 0;) {
+      for (std::size_t j = i + 1; j < n; ++j)
+        b[i] -= lu[i * n + j] * b[j];
+      b[i] /= lu[i * n + i];
+    }
+  }
+};
+
+// Solves (I - gamma_dt J) y = b for a sparse J with BiCGSTAB
+// preconditioned by the diagonal.
+class sparse_rosenbrock_solver {
+  static constexpr double relative_tolerance = 1e-12;
+
+  csr_matrix const* J = nullptr;
+  double gamma_dt = 0.0;
+  std::vector<double> diagonal;
+  rk4_workspace vectors;
+
+  // y = (I - gamma_dt J) x
+  void multiply(std::span<double const> x, std::span<double> y) const {
+    J->multiply(x, y);
+    for (std::size_t i = 0; i < x.size(); ++i)
+      y[i] = x[i] - gamma_dt * y[i];
+  }
+
+  static double dot(std::span<double const> x, std::span<double const> y) {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < x.size(); ++i)
+      sum += x[i] * y[i];
+    return sum;
+  }
+
+public:
+  void factor(csr_matrix const& jacobian, double gamma_dt_) {
+    J = &jacobian;
+    gamma_dt = gamma_dt_;
+    diagonal.assign(J->rows(), 1.0);
+    auto offsets = J->get_row_offsets();
+    auto columns = J->get_columns();
+    auto values = J->get_values();
+    for (std::size_t i = 0; i < J->rows(); ++i) {
+      for (std::size_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+        if (columns[j] == i && gamma_dt * values[j] != 1.0)
+          diagonal[i] = 1.0 - gamma_dt * values[j];
+      }
+    }
+  }
+
+  void solve(std::span<double> b) {
+    std::size_t const n = b.size();
+    auto [y, r, r_0, p, v, p_hat, s_hat, t] = vectors.get<8>(n);
+    for (std::size_t i = 0; i < n; ++i)
+      y[i] = b[i] / diagonal[i];
+    multiply(y, r);
+    for (std::size_t i = 0; i < n; ++i)
+      r[i] = b[i] - r[i];
+    std::ranges::copy(r, r_0.begin());
+    std::ranges::fill(p, 0.0);
+    std::ranges::fill(v, 0.0);
+
+    double threshold = relative_tolerance * std::sqrt(dot(b, b));
+    double rho = 1.0;
+    double alpha = 1.0;
+    double omega = 1.0;
+    std::size_t max_iterations = std::max<std::size_t>(100, 2 * n);
+    for (std::size_t iteration = 0; iteration < max_iterations;
+         ++iteration) {
+      if (std::sqrt(dot(r, r)) <= threshold)
+        break;
+      double rho_next = dot(r_0, r);
+      if (rho_next == 0.0 || omega == 0.0)
+        break;
+      double beta = rho_next / rho * (alpha / omega);
+      rho = rho_next;
+      for (std::size_t i = 0; i < n; ++i) {
+        p[i] = r[i] + beta * (p[i] - omega * v[i]);
+        p_hat[i] = p[i] / diagonal[i];
+      }
+      multiply(p_hat, v);
+      alpha = rho / dot(r_0, v);
+      // r becomes s = r - alpha v.
+      for (std::size_t i = 0; i < n; ++i) {
+        y[i] += alpha * p_hat[i];
+        r[i] -= alpha * v[i];
+      }
+      if (std::sqrt(dot(r, r)) <= threshold)
+        break;
+      for (std::size_t i = 0; i < n; ++i)
+        s_hat[i] = r[i] / diagonal[i];
+      multiply(s_hat, t);
+      double t_t = dot(t, t);
+      omega = t_t == 0.0 ? 0.0 : dot(t, r) / t_t;
+      for (std::size_t i = 0; i < n; ++i) {
+        y[i] += omega * s_hat[i];
+        r[i] -= omega * t[i];
+      }
+    }
+    std::ranges::copy(y, b.begin());
+  }
+};
+
+// The two stage, L-stable, second order Rosenbrock method ROS2 of
+// Verwer et al. which is a W-method, so it keeps its order with
+// any approximation of the Jacobian.
+//
+// factor(t, x, gamma_dt) prepares solve(b) to overwrite b with the
+// solution of (I - gamma_dt J) y = b.
+template <typename Fn, typename Factor, typename Solve,
+          typename ResultVisitorFn, typename Schedule>
+void ros2(Fn& fn, Factor&& factor, Solve&& solve, ResultVisitorFn& result,
+          std::span<double> x, double dt, std::size_t step_count,
+          rk4_workspace& workspace, Schedule schedule) {
+  double const gamma = 1.0 + 1.0 / std::sqrt(2.0);
+  std::size_t const n = x.size();
+  auto [f_0, f_1, k_1, k_2, stage, x_prev] = workspace.get<6>(n);
+  double* f0 = f_0.data();
+  double* f1 = f_1.data();
+  double* xs = x.data();
+  double* k1 = k_1.data();
+  double* k2 = k_2.data();
+  double* s = stage.data();
+  double* xp = x_prev.data();
+
+  auto time_itr = std::ranges::begin(detail::schedule_times(schedule));
+  auto time_end = std::ranges::end(detail::schedule_times(schedule));
+  time_t t = 0.0;
+  if (step_count > 0)
+    fn(t, std::span<double const>(x), std::span(f0, n));
+  for (std::size_t step = 0; step < step_count; ++step) {
+    std::span<double const> x_const = x;
+    factor(t, x_const, gamma * dt);
+    std::copy(f0, f0 + n, k1);
+    solve(k_1);
+    for (std::size_t i = 0; i < n; ++i)
+      s[i] = xs[i] + dt * k1[i];
+    fn(t + dt, std::span<double const>(stage), k_2);
+    for (std::size_t i = 0; i < n; ++i)
+      k2[i] -= 2.0 * k1[i];
+    solve(k_2);
+
+    if constexpr (std::same_as<Schedule, every_k_steps>) {
+      if (step % schedule.k == 0)
+        result(x_const, t);
+    } else {
+      std::ranges::copy(x_const, xp);
+    }
+    for (std::size_t i = 0; i < n; ++i)
+      xs[i] += dt * (1.5 * k1[i] + 0.5 * k2[i]);
+
+    bool is_last = step + 1 == step_count;
+    if (std::same_as<Schedule, at_times> || !is_last)
+      fn(t + dt, x_const, std::span(f1, n));
+    if constexpr (std::same_as<Schedule, at_times>) {
+      for (; time_itr != time_end &&
+             (*time_itr < t + dt || (is_last && *time_itr <= step_count * dt));
+           ++time_itr) {
+        if (*time_itr < t)
+          continue;
+        auto [h_00, h_10, h_01, h_11] =
+          detail::hermite_weights((*time_itr - t) / dt);
+        for (std::size_t i = 0; i < n; ++i)
+          s[i] = h_00 * xp[i] + h_10 * dt * f0[i] +
+                 h_01 * xs[i] + h_11 * dt * f1[i];
+        result(std::span<double const>(stage), *time_itr);
+      }
+    }
+    std::swap(f0, f1);
+    t += dt;
+  }
+}
+}
+
+// Buffers for rosenbrock kept between calls.
+struct rosenbrock_workspace {
+  rk4_workspace vectors;
+  detail::dense_rosenbrock_solver dense;
+  detail::sparse_rosenbrock_solver sparse;
+  // Scratch space for finite differences.
+  std::vector<double> x_shifted;
+  std::vector<double> f_shifted;
+};
+
+// Integrate a stiff system in place with the linearly implicit
+// Rosenbrock method ROS2 calling fn(t, x, dxdt) and result(x, t) as
+// scheduled like the in-place rk4.
+//
+// Each step evaluates the Jacobian at its start with
+// jacobian(t, x, J) and solves two linear systems with one LU
+// factorization. The method is stable for any step size on decaying
+// modes so the step is limited only by accuracy. The system is
+// treated as autonomous within a step, so stiff components driven
+// by terms that depend on t drop to first order. Throws if the
+// linear system is singular.
+template <InPlaceSystemFn Fn, DenseJacobianFn JacobianFn,
+          ResultVisitorFn<std::span<double const>> ResultVisitorFn,
+          OutputSchedule Schedule = every_k_steps>
+void rosenbrock(Fn&& fn, JacobianFn&& jacobian, ResultVisitorFn&& result,
+                std::span<double> x, time_step dt, std::size_t step_count,
+                rosenbrock_workspace& workspace, Schedule schedule = {}) {
+  detail::dense_rosenbrock_solver& solver = workspace.dense;
+  auto factor = [&](time_t t, std::span<double const> x, double gamma_dt) {
+    jacobian(t, x, solver.jacobian(x.size()));
+    solver.factor(gamma_dt);
+  };
+  auto solve = [&](std::span<double> b) { solver.solve(b); };
+  detail::ros2(fn, factor, solve, result, x, dt.value, step_count,
+               workspace.vectors, schedule);
+}
+
+// As above with the sparse Jacobian J whose values are written by
+// jacobian(t, x, J) and linear systems solved iteratively, so the
+// cost of a step grows with the nonzeros of J rather than the cube
+// of the size of x. J may leave out weak couplings such as those
+// between compartments of different groups.
+template <InPlaceSystemFn Fn, SparseJacobianFn JacobianFn,
+          ResultVisitorFn<std::span<double const>> ResultVisitorFn,
+          OutputSchedule Schedule = every_k_steps>
+void rosenbrock(Fn&& fn, JacobianFn&& jacobian, csr_matrix& J,
+                ResultVisitorFn&& result, std::span<double> x,
+                time_step dt, std::size_t step_count,
+                rosenbrock_workspace& workspace, Schedule schedule = {}) {
+  detail::sparse_rosenbrock_solver& solver = workspace.sparse;
+  auto factor = [&](time_t t, std::span<double const> x, double gamma_dt) {
+    jacobian(t, x, J);
+    solver.factor(J, gamma_dt);
+  };
+  auto solve = [&](std::span<double> b) { solver.solve(b); };
+  detail::ros2(fn, factor, solve, result, x, dt.value, step_count,
+               workspace.vectors, schedule);
+}
+
+// As above with a dense Jacobian found by forward differences at the
+// cost of one evaluation per component of x each step.
+template <InPlaceSystemFn Fn,
+          ResultVisitorFn<std::span<double const>> ResultVisitorFn,
+          OutputSchedule Schedule = every_k_steps>
+void rosenbrock(Fn&& fn, ResultVisitorFn&& result, std::span<double> x,
+                time_step dt, std::size_t step_count,
+                rosenbrock_workspace& workspace, Schedule schedule = {}) {
+  std::size_t const n = x.size();
+  workspace.x_shifted.resize(n);
+  workspace.f_shifted.resize(2 * n);
+  auto jacobian = [&](time_t t, std::span<double const> x,
+                      std::span<double> J) {
+    std::span<double> f(workspace.f_shifted.data(), n);
+    std::span<double> f_h(workspace.f_shifted.data() + n, n);
+    std::ranges::copy(x, workspace.x_shifted.begin());
+    fn(t, x, f);
+    for (std::size_t j = 0; j < n; ++j) {
+      double h = std::sqrt(std::numeric_limits<double>::epsilon()) *
+                 std::max(std::abs(x[j]), 1.0);
+      workspace.x_shifted[j] = x[j] + h;
+      fn(t, std::span<double const>(workspace.x_shifted), f_h);
+      workspace.x_shifted[j] = x[j];
+      for (std::size_t i = 0; i < n; ++i)
+        J[i * n + j] = (f_h[i] - f[i]) / h;
+    }
+  };
+  rosenbrock(fn, jacobian, result, x, dt, step_count, workspace, schedule);
+}
+
+// As above for a State of contiguous doubles where fn(t, x) returns
+// dx/dt as with rk4.
+template <ContiguousState State,
+          SystemFn<State> Fn,
+          ResultVisitorFn<State> ResultVisitorFn,
+          OutputSchedule Schedule = every_k_steps>
+  requires std::semiregular<State>
+void rosenbrock(Fn&& fn, ResultVisitorFn&& result, State initial_state,
+                time_step dt, std::size_t step_count,
+                Schedule schedule = {}) {
+  State x = initial_state;
+  State y = initial_state;
+  auto in_place_fn = [&](time_t t, std::span<double const> x,
+                         std::span<double> dxdt) {
+    std::ranges::copy(x, std::ranges::begin(y));
+    State dydt = fn(t, y);
+    std::ranges::copy(dydt, dxdt.begin());
+  };
+  auto in_place_result = [&](std::span<double const> x, time_t t) {
+    std::ranges::copy(x, std::ranges::begin(y));
+    result(y, t);
+  };
+  rosenbrock_workspace workspace;
+  rosenbrock(in_place_fn, in_place_result, std::span<double>(x), dt,
+             step_count, workspace, schedule);
+}
+
+}  // namespace abmoid
+
+#endif
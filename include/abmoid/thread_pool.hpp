@@ -0,0 +1,167 @@
+#ifndef ABMOID_THREAD_POOL_HPP
+#define ABMOID_THREAD_POOL_HPP
+
+#include <abmoid/affinity.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace abmoid {
+
+// A fixed set of threads for fork-join loops over many frames.
+// The calling thread takes part in each loop as thread 0
+// so a pool of size 1 runs everything inline. If the affinity
+// pins thread 0, the calling thread stays pinned until the pool is
+// destroyed, which must be done from the same thread.
+class thread_pool {
+  std::vector<std::jthread> workers;
+  // The affinity of the calling thread before it was pinned.
+  thread_affinity caller_affinity;
+  std::mutex mutex;
+  std::condition_variable work_ready;
+  std::condition_variable work_done;
+  std::function<void(unsigned)> task;
+  std::size_t generation = 0;
+  unsigned busy = 0;
+  // The first exception thrown by a worker during the current task.
+  std::exception_ptr error;
+  bool stopping = false;
+
+  void work(unsigned thread_index, int cpu) {
+    if (cpu >= 0)
+      pin_current_thread(cpu);
+
+    std::size_t seen = 0;
+    while (true) {
+      {
+        std::unique_lock lock(mutex);
+        work_ready.wait(lock, [&] {
+          return stopping || generation != seen;
+        });
+        if (stopping)
+          return;
+        seen = generation;
+      }
+
+      std::exception_ptr task_error;
+      try {
+        task(thread_index);
+      } catch (...) {
+        task_error = std::current_exception();
+      }
+
+      std::lock_guard lock(mutex);
+      if (task_error && !error)
+        error = task_error;
+      if (--busy == 0)
+        work_done.notify_one();
+    }
+  }
+
+public:
+  explicit thread_pool(
+      unsigned num_threads = std::thread::hardware_concurrency(),
+      affinity_policy const& affinity = {}) {
+    num_threads = std::max(num_threads, 1u);
+    // The calling thread is thread 0.
+    if (int cpu = affinity.get_cpu(0); cpu >= 0) {
+      caller_affinity = thread_affinity::get_current();
+      pin_current_thread(cpu);
+    }
+    for (unsigned i = 1; i < num_threads; ++i)
+      workers.emplace_back([this, i, cpu = affinity.get_cpu(i)] {
+        work(i, cpu);
+      });
+  }
+
+  thread_pool(thread_pool const&) = delete;
+  thread_pool& operator=(thread_pool const&) = delete;
+
+  ~thread_pool() {
+    {
+      std::lock_guard lock(mutex);
+      stopping = true;
+    }
+    work_ready.notify_all();
+    // Join before the members they wait on are destroyed.
+    workers.clear();
+    caller_affinity.restore();
+  }
+
+  // Number of threads including the calling thread.
+  unsigned size() const {
+    return workers.size() + 1;
+  }
+
+  // Call fn(i, thread_index) for each i in [0, n) and wait for
+  // all of them to finish. Indices are handed out dynamically so
+  // which thread runs an index is not deterministic. Once fn throws
+  // no more indices are handed out and the exception is rethrown
+  // after the rest finish.
+  template <typename Fn>
+  void parallel_for(std::size_t n, Fn&& fn) {
+    std::atomic<std::size_t> next = 0;
+    auto run = [&](unsigned thread_index) {
+      for (std::size_t i = next++; i < n; i = next++) {
+        try {
+          fn(i, thread_index);
+        } catch (...) {
+          next = n;
+          throw;
+        }
+      }
+    };
+
+    if (workers.empty() || n < 2)
+      run(0);
+    else
+      for_each_thread(run);
+  }
+
+  // Call fn(thread_index) once on every thread and wait for all of
+  // them to finish. Work that is always given to the same thread
+  // keeps its memory local to that thread. If fn throws on any
+  // thread, the first exception is rethrown once every thread is
+  // done with fn.
+  template <typename Fn>
+  void for_each_thread(Fn&& fn) {
+    if (!workers.empty()) {
+      {
+        std::lock_guard lock(mutex);
+        task = std::ref(fn);
+        busy = workers.size();
+        error = nullptr;
+        ++generation;
+      }
+      work_ready.notify_all();
+    }
+
+    std::exception_ptr first_error;
+    try {
+      fn(0u);
+    } catch (...) {
+      first_error = std::current_exception();
+    }
+
+    if (!workers.empty()) {
+      std::unique_lock lock(mutex);
+      work_done.wait(lock, [&] { return busy == 0; });
+      if (!first_error)
+        first_error = error;
+      error = nullptr;
+    }
+    if (first_error)
+      std::rethrow_exception(first_error);
+  }
+};
+
+}  // namespace abmoid
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef ABMOID_WORK_STEALING_POOL_HPP
+#define ABMOID_WORK_STEALING_POOL_HPP
+
+#include <abmoid/affinity.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace abmoid {
+
+// A persistent set of threads for running many independent jobs
+// of uneven length such as the runs of a parameter sweep.
+//
+// Each worker owns a queue. Jobs submitted from a worker go to that
+// worker's queue and it takes the newest of them first. Jobs
+// submitted from outside the pool are spread over the queues and
+// taken oldest first so they start about in the order they were
+// submitted. A worker with nothing of its own steals the oldest job
+// of another worker, so no thread sits idle while any job is
+// waiting.
+class work_stealing_pool {
+  using job = std::move_only_function<void()>;
+
+  struct job_queue {
+    std::mutex mutex;
+    // Submitted from the owning worker.
+    std::deque<job> local;
+    // Submitted from outside the pool.
+    std::deque<job> external;
+  };
+
+  std::vector<std::unique_ptr<job_queue>> queues;
+  std::vector<std::jthread> workers;
+  std::mutex mutex;
+  std::condition_variable job_ready;
+  // Jobs in the queues that no worker has taken yet.
+  std::atomic<std::size_t> pending = 0;
+  std::atomic<unsigned> next_queue = 0;
+  bool stopping = false;
+
+  // Identify the pool and queue of the current worker thread.
+  inline static thread_local work_stealing_pool* current_pool = nullptr;
+  inline static thread_local unsigned current_index = 0;
+
+  static void take_front(std::deque<job>& jobs, job& j) {
+    j = std::move(jobs.front());
+    jobs.pop_front();
+  }
+
+  bool pop(unsigned index, job& j) {
+    job_queue& q = *queues[index];
+    std::lock_guard lock(q.mutex);
+    if (!q.local.empty()) {
+      j = std::move(q.local.back());
+      q.local.pop_back();
+    } else if (!q.external.empty()) {
+      take_front(q.external, j);
+    } else {
+      return false;
+    }
+    --pending;
+    return true;
+  }
+
+  bool steal(unsigned index, job& j) {
+    for (unsigned i = 1; i < queues.size(); ++i) {
+      job_queue& q = *queues[(index + i) % queues.size()];
+      std::lock_guard lock(q.mutex);
+      if (!q.external.empty())
+        take_front(q.external, j);
+      else if (!q.local.empty())
+        take_front(q.local, j);
+      else
+        continue;
+      --pending;
+      return true;
+    }
+    return false;
+  }
+
+  void work(unsigned index, int cpu) {
+    if (cpu >= 0)
+      pin_current_thread(cpu);
+    current_pool = this;
+    current_index = index;
+    while (true) {
+      job j;
+      if (pop(index, j) || steal(index, j)) {
+        j();
+        continue;
+      }
+
+      std::unique_lock lock(mutex);
+      job_ready.wait(lock, [&] { return stopping || pending > 0; });
+      if (stopping && pending == 0)
+        return;
+    }
+  }
+
+public:
+  // With one model per job, a pinned worker allocates and first
+  // touches the memory of its model on its own NUMA node.
+  explicit work_stealing_pool(
+      unsigned num_threads = std::thread::hardware_concurrency(),
+      affinity_policy const& affinity = {}) {
+    num_threads = std::max(num_threads, 1u);
+    for (unsigned i = 0; i < num_threads; ++i)
+      queues.push_back(std::make_unique<job_queue>());
+    for (unsigned i = 0; i < num_threads; ++i)
+      workers.emplace_back([this, i, cpu = affinity.get_cpu(i)] {
+        work(i, cpu);
+      });
+  }
+
+  work_stealing_pool(work_stealing_pool const&) = delete;
+  work_stealing_pool& operator=(work_stealing_pool const&) = delete;
+
+  // Finish the queued jobs and join.
+  ~work_stealing_pool() {
+    {
+      std::lock_guard lock(mutex);
+      stopping = true;
+    }
+    job_ready.notify_all();
+    workers.clear();
+  }
+
+  unsigned size() const {
+    return workers.size();
+  }
+
+  template <typename Job>
+  void submit(Job&& j) {
+    bool is_local = current_pool == this;
+    unsigned index = is_local
+      ? current_index
+      : next_queue++ % queues.size();
+    {
+      // Count under the lock so a worker cannot miss the wake up,
+      // and before the push so a thief never takes it below zero.
+      std::lock_guard lock(mutex);
+      ++pending;
+    }
+    {
+      job_queue& q = *queues[index];
+      std::lock_guard lock(q.mutex);
+      (is_local ? q.local : q.external).emplace_back(std::forward<Job>(j));
+    }
+    job_ready.notify_one();
+  }
+};
+
+}  // namespace abmoid
+
+#endif